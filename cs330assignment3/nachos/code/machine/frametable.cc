@@ -0,0 +1,275 @@
+// frametable.cc
+//	Routines to keep track of the physical page frames of the
+//	simulated machine.  See frametable.h for an overview.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "frametable.h"
+#include "machine.h"
+
+//----------------------------------------------------------------------
+// FrameTable::FrameTable
+// 	Initialize the descriptors of "numFrames" frames, all of them
+//	on the free list, in increasing order.
+//----------------------------------------------------------------------
+
+FrameTable::FrameTable(int n)
+{
+    int i;
+
+    numFrames = n;
+    frames = new FrameDescriptor[numFrames];
+    for (i = 0; i < 4; i++)
+	listHead[i] = listTail[i] = -1;
+    numBusy = 0;
+    for (i = 0; i < numFrames; i++) {
+	frames[i].owner = -1;
+	frames[i].vpn = -1;
+	frames[i].refCount = 0;
+	frames[i].age = 0;
+	frames[i].flags = 0;
+	Append(FreeFrames, i);
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameTable::~FrameTable
+// 	De-allocate the descriptors.
+//----------------------------------------------------------------------
+
+FrameTable::~FrameTable()
+{
+    delete [] frames;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Allocate
+// 	Take a free frame, and put it at the end of the active list.  The
+//	caller fills in the owner.
+//
+//	A caller that wants a zeroed frame gets one from the zeroed list
+//	if it can, and can tell by FrameZeroed; the others take frames
+//	from the plain free list first, to keep the zeroed ones.
+//
+// Returns:
+//	The frame number, -1 if no frame is free.
+//----------------------------------------------------------------------
+
+int
+FrameTable::Allocate(bool zeroed)
+{
+    int frame;
+
+    if (zeroed)
+	frame = (listHead[ZeroedFrames] != -1) ? listHead[ZeroedFrames]
+						: listHead[FreeFrames];
+    else
+	frame = (listHead[FreeFrames] != -1) ? listHead[FreeFrames]
+						: listHead[ZeroedFrames];
+    if (frame == -1)
+	return -1;
+    if (!zeroed)
+	frames[frame].flags &= ~FrameZeroed;
+    Unlink(frame);
+    Append(ActiveFrames, frame);
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::ZeroFreeFrames
+// 	Clear up to "n" frames of the free list, and move them to the
+//	zeroed list.  Each frame is cleared whole, with memset, which the
+//	C library vectorizes.
+//
+//	"memory" -- the machine's main memory
+//
+// Returns:
+//	The number of frames zeroed.
+//----------------------------------------------------------------------
+
+int
+FrameTable::ZeroFreeFrames(char *memory, int n)
+{
+    int frame, done;
+
+    for (done = 0; (done < n) && (listHead[FreeFrames] != -1); done++) {
+	frame = listHead[FreeFrames];
+	memset(memory + frame * PageSize, 0, PageSize);
+	frames[frame].flags |= FrameZeroed;
+	Unlink(frame);
+	Append(ZeroedFrames, frame);
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Free
+// 	Put a frame back on the free list, forgetting everything about it.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Free(int frame)
+{
+    FrameDescriptor *f = &frames[frame];
+
+    ASSERT((f->list != FreeFrames) && (f->list != ZeroedFrames));
+    f->owner = -1;
+    f->vpn = -1;
+    f->refCount = 0;
+    f->flags = 0;
+    Unlink(frame);
+    Append(FreeFrames, frame);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Pin
+// 	Keep an allocated frame resident for good: it moves to the
+//	inactive list, where page replacement never looks.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Pin(int frame)
+{
+    ASSERT(frames[frame].list == ActiveFrames);
+    frames[frame].flags |= FrameShared;
+    Unlink(frame);
+    Append(InactiveFrames, frame);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::HasVictim
+// 	Return TRUE if page replacement can pick some frame other than
+//	"except" (-1 for none).
+//----------------------------------------------------------------------
+
+bool
+FrameTable::HasVictim(int except)
+{
+    int first = listHead[ActiveFrames];
+
+    return ((first != -1) && ((first != except) || (frames[first].next != -1)));
+}
+
+//----------------------------------------------------------------------
+// FrameTable::BeginIO
+// 	A page is about to be read into an active frame: take it out of
+//	reach of page replacement until EndIO.
+//----------------------------------------------------------------------
+
+void
+FrameTable::BeginIO(int frame)
+{
+    ASSERT(frames[frame].list == ActiveFrames);
+    frames[frame].flags |= FrameBusy;
+    Unlink(frame);
+    Append(InactiveFrames, frame);
+    numBusy++;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::EndIO
+// 	The read started by BeginIO is done: the frame becomes the newest
+//	active frame.
+//----------------------------------------------------------------------
+
+void
+FrameTable::EndIO(int frame)
+{
+    ASSERT(frames[frame].flags & FrameBusy);
+    frames[frame].flags &= ~FrameBusy;
+    Unlink(frame);
+    Append(ActiveFrames, frame);
+    numBusy--;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::MoveToTail
+// 	Move an active frame to the end of the active list, so that it
+//	is the last one FIFO or LRU would pick.
+//----------------------------------------------------------------------
+
+void
+FrameTable::MoveToTail(int frame)
+{
+    ASSERT(frames[frame].list == ActiveFrames);
+    if (listTail[ActiveFrames] == frame)
+	return;
+    Unlink(frame);
+    Append(ActiveFrames, frame);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Touch
+// 	Record a reference to a frame at time "now", for LRU: the active
+//	list is kept in order of last reference.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Touch(int frame, int now)
+{
+    frames[frame].age = now;
+    if (frames[frame].list == ActiveFrames)
+	MoveToTail(frame);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Print
+// 	Print every frame, for debugging.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Print()
+{
+    static char *listName[] = { "free", "active", "inactive", "zeroed" };
+    int i;
+
+    printf("Frame table:\n");
+    for (i = 0; i < numFrames; i++)
+	printf("\t%d: %s, pid %d, vpn %d, refs %d, age %d, flags %x\n", i,
+	    listName[frames[i].list], frames[i].owner, frames[i].vpn,
+	    frames[i].refCount, frames[i].age, frames[i].flags);
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Append
+// 	Put a frame that is on no list at the end of "list".
+//----------------------------------------------------------------------
+
+void
+FrameTable::Append(FrameList list, int frame)
+{
+    FrameDescriptor *f = &frames[frame];
+
+    f->list = list;
+    f->next = -1;
+    f->prev = listTail[list];
+    if (listTail[list] == -1)
+	listHead[list] = frame;
+    else
+	frames[listTail[list]].next = frame;
+    listTail[list] = frame;
+}
+
+//----------------------------------------------------------------------
+// FrameTable::Unlink
+// 	Take a frame off the list it is on.
+//----------------------------------------------------------------------
+
+void
+FrameTable::Unlink(int frame)
+{
+    FrameDescriptor *f = &frames[frame];
+
+    if (f->prev == -1)
+	listHead[f->list] = f->next;
+    else
+	frames[f->prev].next = f->next;
+    if (f->next == -1)
+	listTail[f->list] = f->prev;
+    else
+	frames[f->next].prev = f->prev;
+    f->prev = f->next = -1;
+}
@@ -0,0 +1,106 @@
+// frametable.h
+//	Data structures describing the physical page frames of the
+//	simulated machine.
+//
+//	Each frame has one small descriptor, and the descriptors are kept
+//	in a single array, so that everything the page replacement code
+//	needs to know about a frame is in one place.  Every frame is on
+//	exactly one of four lists, linked through its descriptor:
+//
+//	  free		not allocated to any address space
+//	  zeroed	free, and known to hold only zeros: frames are
+//			zeroed while the CPU is idle, so that a page that
+//			starts out zero can be given one without clearing
+//			it on the fault path
+//	  active	resident user pages that may be replaced, in the order
+//			the replacement algorithm wants them: order of
+//			allocation for FIFO, of last reference for LRU
+//	  inactive	resident pages that are not replaced: shared memory,
+//			for good, and pages being read in, until the
+//			read is done
+//
+//	so that finding a free frame, or the FIFO or LRU victim, does
+//	not need a scan over all frames.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The lists a frame can be on.
+enum FrameList { FreeFrames, ActiveFrames, InactiveFrames, ZeroedFrames };
+
+// Frame flags
+#define FrameShared	0x1	// shared memory page, on the inactive list
+#define FrameReferenced	0x2	// reference bit, for the clock algorithms
+#define FrameCached	0x4	// holds a page of the page cache
+#define FrameBusy	0x8	// page being read in, on the inactive list
+#define FramePrefetched	0x10	// read ahead by fault-around, not yet used
+#define FrameZeroed	0x20	// all zeros: on the zeroed list, or just
+				// allocated from it
+
+// The state of one physical page frame.
+
+class FrameDescriptor {
+  public:
+    int owner;			// pid of the address space the frame is
+				// recorded under, -1 if free
+    int vpn;			// which page of that space it holds
+    int refCount;		// page tables mapping it, more than one
+				// if shared copy-on-write or cached
+    int age;			// tick of the last reference (LRU only)
+    int prev, next;		// neighbours on its list, -1 at the ends
+    unsigned char list;		// which FrameList it is on
+    unsigned char flags;	// FrameShared, FrameReferenced, FrameCached,
+				// FrameBusy, FramePrefetched, FrameZeroed
+};
+
+// The descriptors of all the frames of the machine.
+
+class FrameTable {
+  public:
+    FrameTable(int numFrames);		// all frames start out free
+    ~FrameTable();
+
+    FrameDescriptor *Frame(int frame) { return &frames[frame]; }
+
+    int Allocate(bool zeroed);		// take a free frame, zeroed if asked
+					// for and there is one, and put it
+					// at the end of the active list;
+					// -1 if there is none
+    int ZeroFreeFrames(char *memory, int n);	// zero up to "n" free
+					// frames of "memory"
+    void Free(int frame);		// put a frame back on the free list
+    void Pin(int frame);		// move a frame to the inactive list
+    bool IsReplaceable(int frame)
+	{ return (frames[frame].list == ActiveFrames); }
+    bool HasVictim(int except);		// some frame but "except" can be
+					// replaced
+
+    void BeginIO(int frame);		// keep a frame out of replacement
+    void EndIO(int frame);		// while a page is read into it
+    int NumBusy() { return numBusy; }
+
+    int FirstActive() { return listHead[ActiveFrames]; }
+    void MoveToTail(int frame);		// an active frame becomes the newest
+    void Touch(int frame, int now);	// an active frame was referenced now
+					// (LRU order)
+
+    void Print();			// print the frames, for debugging
+
+  private:
+    FrameDescriptor *frames;
+    int numFrames;
+    int listHead[4], listTail[4];	// ends of each FrameList
+    int numBusy;			// frames between BeginIO and EndIO
+
+    void Append(FrameList list, int frame);
+    void Unlink(int frame);
+};
+
+#endif // FRAMETABLE_H
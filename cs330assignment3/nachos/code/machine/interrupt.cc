@@ -48,6 +48,8 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
     arg = param;
     when = time;
     type = kind;
+    order = 0;
+    next = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -60,7 +62,12 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    maxPending = 64;
+    numPending = 0;
+    pending = new PendingInterrupt *[maxPending];
+    tied = new PendingInterrupt *[maxPending];
+    nextOrder = 0;
+    freePending = NULL;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -73,9 +80,17 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-	delete pending->Remove();
-    delete pending;
+    PendingInterrupt *toFree;
+
+    while (numPending > 0)
+	delete RemovePending();
+    while (freePending != NULL) {
+	toFree = freePending;
+	freePending = toFree->next;
+	delete toFree;
+    }
+    delete [] pending;
+    delete [] tied;
 }
 
 //----------------------------------------------------------------------
@@ -150,8 +165,6 @@ Interrupt::Enable()
 void
 Interrupt::OneTick()
 {
-    MachineStatus old = status;
-
 // advance simulated time
     if (status == SystemMode) {
         stats->totalTicks += SystemTick;
@@ -162,6 +175,63 @@ Interrupt::OneTick()
     }
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
+    FireDueInterrupts();
+}
+
+//----------------------------------------------------------------------
+// Interrupt::UserTicks
+// 	Advance simulated time by "n" user instructions in one step, and
+//	then check for pending interrupts.
+//
+//	Used by Machine::Run, which runs user code straight up to the
+//	next interrupt deadline.  The result is the same as "n" calls to
+//	OneTick, provided no interrupt comes due before the last of them.
+//----------------------------------------------------------------------
+
+void
+Interrupt::UserTicks(int n)
+{
+    ASSERT((status == UserMode) && (n > 0));
+
+    // Each of the first n-1 ticks would have taken the earliest
+    // interrupt off the queue, found it not due, and put it back
+    // behind any others due at the same time.  Do the same, so tied
+    // interrupts still fire in the same order.
+    RequeueFirst(n - 1);
+
+    stats->totalTicks += n * UserTick;
+    stats->userTicks += n * UserTick;
+    DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
+
+    FireDueInterrupts();
+}
+
+//----------------------------------------------------------------------
+// Interrupt::NextDueTime
+// 	Return the simulated time at which the earliest pending interrupt
+//	is to occur, or a time far in the future if none is pending.
+//----------------------------------------------------------------------
+
+int
+Interrupt::NextDueTime()
+{
+    if (numPending == 0)
+	return 0x7fffffff;
+    return pending[0]->when;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::FireDueInterrupts
+// 	Invoke the handlers of all the pending interrupts whose time has
+//	come, and then do the context switch a handler may have asked
+//	for.  The second half of OneTick.
+//----------------------------------------------------------------------
+
+void
+Interrupt::FireDueInterrupts()
+{
+    MachineStatus old = status;
+
 // check any pending interrupts are now ready to fire
     ChangeLevel(IntOn, IntOff);		// first, turn off interrupts
 					// (interrupt handlers run with
@@ -212,6 +282,11 @@ Interrupt::Idle()
 {
     DEBUG('i', "Machine idling; checking for interrupts.\n");
     status = IdleMode;
+#ifdef USER_PROGRAM
+    // nothing to run: clear some free frames for zero-fill faults
+    stats->framesZeroed += machine->frameTable->ZeroFreeFrames(machine->mainMemory,
+							IDLE_ZERO_BATCH);
+#endif
     if (CheckIfDue(TRUE)) {		// check for any pending interrupts
     	while (CheckIfDue(FALSE))	// check for any other pending 
 	    ;				// interrupts
@@ -246,6 +321,11 @@ Interrupt::Halt()
 
     printf("Machine halting!\n\n");
     stats->Print();
+#ifdef USER_PROGRAM
+    if (loadController != NULL)
+       loadController->Print();
+    PrintSyscallStatistics();
+#endif
 
     if (schedulingAlgo == NON_PREEMPTIVE_SJF) {
        printf("Error in burst estimate over average burst length: %.2f\n", ((float)stats->burstEstimateError)/stats->cpu_time);
@@ -300,7 +380,8 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: take a PendingInterrupt from the pool and put
+//	it on the heap.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -315,13 +396,155 @@ void
 Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 {
     int when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
+    PendingInterrupt *toOccur = freePending;
+
+    if (toOccur == NULL)
+	toOccur = new PendingInterrupt(handler, arg, when, type);
+    else {
+	freePending = toOccur->next;
+	toOccur->handler = handler;
+	toOccur->arg = arg;
+	toOccur->when = when;
+	toOccur->type = type;
+    }
 
     DEBUG('i', "Scheduling interrupt handler the %s at time = %d\n", 
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    InsertPending(toOccur);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Earlier
+// 	Is interrupt "a" to fire before interrupt "b"?  Interrupts due
+//	at the same time fire in the order they were queued, which is
+//	what the sorted list used to give us.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::Earlier(PendingInterrupt *a, PendingInterrupt *b)
+{
+    if (a->when != b->when)
+	return (a->when < b->when);
+    return (a->order < b->order);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::SiftUp, Interrupt::SiftDown
+// 	Restore the heap property after the interrupt at position "i"
+//	has moved earlier or later, respectively.
+//----------------------------------------------------------------------
+
+void
+Interrupt::SiftUp(int i)
+{
+    PendingInterrupt *toMove = pending[i];
+    int parent;
+
+    while (i > 0) {
+	parent = (i - 1) / 2;
+	if (!Earlier(toMove, pending[parent]))
+	    break;
+	pending[i] = pending[parent];
+	i = parent;
+    }
+    pending[i] = toMove;
+}
+
+void
+Interrupt::SiftDown(int i)
+{
+    PendingInterrupt *toMove = pending[i];
+    int child;
+
+    for (;;) {
+	child = 2 * i + 1;
+	if (child >= numPending)
+	    break;
+	if ((child + 1 < numPending) && Earlier(pending[child + 1], pending[child]))
+	    child++;
+	if (!Earlier(pending[child], toMove))
+	    break;
+	pending[i] = pending[child];
+	i = child;
+    }
+    pending[i] = toMove;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::InsertPending
+// 	Put an interrupt on the heap, behind any interrupts already
+//	queued for the same time.  The heap array doubles when full.
+//----------------------------------------------------------------------
+
+void
+Interrupt::InsertPending(PendingInterrupt *toOccur)
+{
+    PendingInterrupt **bigger;
+    int i;
+
+    if (numPending == maxPending) {
+	bigger = new PendingInterrupt *[2 * maxPending];
+	for (i = 0; i < numPending; i++)
+	    bigger[i] = pending[i];
+	delete [] pending;
+	delete [] tied;
+	pending = bigger;
+	maxPending *= 2;
+	tied = new PendingInterrupt *[maxPending];
+    }
+    toOccur->order = nextOrder++;
+    pending[numPending] = toOccur;
+    SiftUp(numPending++);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::RemovePending
+// 	Take the earliest interrupt off the heap, and return it.
+//----------------------------------------------------------------------
+
+PendingInterrupt *
+Interrupt::RemovePending()
+{
+    PendingInterrupt *first = pending[0];
+
+    ASSERT(numPending > 0);
+    pending[0] = pending[--numPending];
+    if (numPending > 0)
+	SiftDown(0);
+    return first;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::RequeueFirst
+// 	Have the effect of "count" times taking the earliest interrupt
+//	off the heap and queueing it again, which is what checking an
+//	interrupt that is not yet due used to do to the sorted list: the
+//	interrupts tied for the earliest time are rotated.
+//
+//	A single requeue just restamps the first interrupt; for more, we
+//	take all the tied interrupts off, and put them back rotated.
+//----------------------------------------------------------------------
+
+void
+Interrupt::RequeueFirst(int count)
+{
+    int numTied = 0, when, i;
+
+    if ((numPending == 0) || (count == 0))
+	return;
+    if (count == 1) {
+	pending[0]->order = nextOrder++;
+	SiftDown(0);
+	return;
+    }
+    when = pending[0]->when;
+    while ((numPending > 0) && (pending[0]->when == when))
+	tied[numTied++] = RemovePending();
+    count %= numTied;
+    for (i = 0; i < numTied; i++)
+	InsertPending(tied[(count + i) % numTied]);
 }
 
 //----------------------------------------------------------------------
@@ -347,29 +570,32 @@ Interrupt::CheckIfDue(bool advanceClock)
 					// to invoke an interrupt handler
     if (DebugIsEnabled('i'))
 	DumpState();
-    PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
+    PendingInterrupt *toOccur;
 
-    if (toOccur == NULL)		// no pending interrupts
+    if (numPending == 0)		// no pending interrupts
 	return FALSE;			
+    toOccur = pending[0];
+    when = toOccur->when;
 
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
     } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+	RequeueFirst(1);
 	return FALSE;
     }
 
 // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+				&& (numPending == 1))
 	 return FALSE;
-    }
+    RemovePending();
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
 			intTypeNames[toOccur->type], toOccur->when);
+    if (clockCheck)
+	printf("Clock: %s interrupt due at %d fired at %d\n",
+	       intTypeNames[toOccur->type], toOccur->when, stats->totalTicks);
 #ifdef USER_PROGRAM
     if (machine != NULL)
     	machine->DelayedLoad(0, 0);
@@ -381,7 +607,8 @@ Interrupt::CheckIfDue(bool advanceClock)
     (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
     status = old;				// restore the machine status
     inHandler = FALSE;
-    delete toOccur;
+    toOccur->next = freePending;		// back to the pool
+    freePending = toOccur;
     return TRUE;
 }
 
@@ -413,7 +640,8 @@ Interrupt::DumpState()
 					intLevelNames[level]);
     printf("Pending interrupts:\n");
     fflush(stdout);
-    pending->Mapcar(PrintPending);
+    for (int i = 0; i < numPending; i++)	// in heap order
+	PrintPending((int) pending[i]);
     printf("End of pending interrupts\n");
     fflush(stdout);
 }
@@ -67,6 +67,9 @@ class PendingInterrupt {
     int arg;                    // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    unsigned order;		// Arrival stamp; interrupts due at the
+				// same time fire in stamp order
+    PendingInterrupt *next;	// Next unused interrupt in the pool
 };
 
 // The following class defines the data structures for the simulation
@@ -112,10 +115,24 @@ class Interrupt {
     
     void OneTick();       		// Advance simulated time
 
+    void UserTicks(int n);		// Advance simulated time by "n"
+					// user instructions at once
+
+    int NextDueTime();			// When the earliest pending
+					// interrupt is to occur
+
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
-				// to occur in the future
+    PendingInterrupt **pending;	// the interrupts scheduled to occur in
+				// the future, kept as an array-based
+				// min-heap ordered by (when, order)
+    int numPending;		// number of interrupts in the heap
+    int maxPending;		// size of the heap array
+    PendingInterrupt **tied;	// scratch array used by RequeueFirst
+    unsigned nextOrder;		// stamp for the next interrupt queued
+    PendingInterrupt *freePending;	// pool of PendingInterrupts that
+				// are not in use, to avoid an allocation
+				// per scheduled interrupt
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
@@ -126,6 +143,19 @@ class Interrupt {
     bool CheckIfDue(bool advanceClock); // Check if an interrupt is supposed
 					// to occur now
 
+    void FireDueInterrupts();		// Run the handlers of all due
+					// interrupts, and yield if asked to
+
+    // the pending interrupt heap
+    bool Earlier(PendingInterrupt *a, PendingInterrupt *b);
+    void SiftUp(int i);
+    void SiftDown(int i);
+    void InsertPending(PendingInterrupt *toOccur);
+    PendingInterrupt *RemovePending();	// take off the earliest one
+    void RequeueFirst(int count);	// as if the earliest interrupt were
+					// taken off and queued again, "count"
+					// times
+
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
 	IntStatus now);  		// simulated time
 };
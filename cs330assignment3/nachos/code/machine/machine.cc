@@ -62,28 +62,30 @@ Machine::Machine(bool debug)
   for (i = 0; i < MemorySize; i++)
     mainMemory[i] = 0;
 
-  PhysToVirtual = new int[NumPhysPages];
-  PIDatPhysAddr = new int[NumPhysPages];
-  shared = new bool[NumPhysPages];
-  TimeStamp = new unsigned long int[NumPhysPages];
-  ReferenceBitSet = new bool[NumPhysPages];
-
-  for (i = 0; i < NumPhysPages; i++) {
-    PhysToVirtual[i] = -1;
-    PIDatPhysAddr[i] = -1;
-    shared[i] = false;
-    TimeStamp[i] = 0;
-    ReferenceBitSet[i] = false;
+  frameTable = new FrameTable(NumPhysPages);
+
+  decodedInstr = new Instruction[MemorySize / 4];
+  decodedValid = new bool[MemorySize / 4];
+  blockLength = new int[MemorySize / 4];
+  for (i = 0; i < MemorySize / 4; i++) {
+    decodedValid[i] = FALSE;
+    blockLength[i] = 0;
   }
+  translationEpoch = 0;
+  batchClock = FALSE;
+  unsettledTicks = unsettledInstrs = 0;
+  clockDeadline = 0;
 
-#ifdef USE_TLB
-  tlb = new TranslationEntry[TLBSize];
-  for (i = 0; i < TLBSize; i++)
-    tlb[i].valid = FALSE;
-  KernelPageTable = NULL;
-#else	// use linear page table
   tlb = NULL;
+  tlbASID = tlbHand = NULL;
+  tlbSource = NULL;
+  tlbSize = tlbWays = 0;
+  currentASID = -1;
+  for (i = 0; i < HostCacheSize; i++)
+    hostCache[i].vpn = hostCache[i].asid = -1;
   KernelPageTable = NULL;
+#ifdef USE_TLB
+  EnableTLB(TLBSize, TLBSize);
 #endif
 
   singleStep = debug;
@@ -98,13 +100,16 @@ Machine::Machine(bool debug)
 Machine::~Machine()
 {
   delete [] mainMemory;
-  delete [] PhysToVirtual;
-  delete [] PIDatPhysAddr;
-  delete [] TimeStamp;
-  delete [] shared;
-  delete [] ReferenceBitSet;
-  if (tlb != NULL)
+  delete frameTable;
+  delete [] decodedInstr;
+  delete [] decodedValid;
+  delete [] blockLength;
+  if (tlb != NULL) {
     delete [] tlb;
+    delete [] tlbASID;
+    delete [] tlbSource;
+    delete [] tlbHand;
+  }
 }
 
 //----------------------------------------------------------------------
@@ -123,11 +128,42 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
   DEBUG('m', "Exception: %s\n", exceptionNames[which]);
 
   //  ASSERT(interrupt->getStatus() == UserMode);
+  SettleClock();			// the kernel must see the exact time
+  if (clockCheck)
+      printf("Clock: %s by \"%s\" at %d, %d instructions\n",
+	     exceptionNames[which], currentThread->getName(), stats->totalTicks,
+	     currentThread->GetInstructionCount());
   registers[BadVAddrReg] = badVAddr;
   DelayedLoad(0, 0);			// finish anything in progress
   interrupt->setStatus(SystemMode);
   ExceptionHandler(which);		// interrupts are enabled at this point
   interrupt->setStatus(UserMode);
+  clockDeadline = interrupt->NextDueTime();	// the kernel may have
+						// scheduled interrupts
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecodedFrame
+// 	Throw away the predecoded instructions and translated blocks of
+//	one physical page.  Called by the kernel whenever the frame is
+//	handed to a new virtual page, since its contents are about to be
+//	overwritten without going through WriteMem, and by WriteMem
+//	when a store hits a decoded word.
+//
+//	"frame" -- the physical page number
+//----------------------------------------------------------------------
+
+  void
+Machine::InvalidateDecodedFrame(int frame)
+{
+  int i, first = frame * (PageSize / 4);
+
+  ASSERT((frame >= 0) && (frame < NumPhysPages));
+  for (i = 0; i < PageSize / 4; i++) {
+    decodedValid[first + i] = FALSE;
+    blockLength[first + i] = 0;
+  }
+  translationEpoch++;
 }
 
 //----------------------------------------------------------------------
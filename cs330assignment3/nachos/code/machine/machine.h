@@ -25,6 +25,7 @@
 #include "utility.h"
 #include "translate.h"
 #include "disk.h"
+#include "frametable.h"
 
 // Definitions related to the size, and format of user memory
 
@@ -36,7 +37,10 @@
 #define NumPhysPages  15
 // #define NumPhysPages    1024
 #define MemorySize 	(NumPhysPages * PageSize)
-#define TLBSize		4		// if there is a TLB, make it small
+#define TLBSize		4		// if there is a TLB, make it small,
+					// unless -tlb says otherwise
+#define MaxTLBSize	64
+#define HostCacheSize	32		// entries of the host translation cache
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -92,6 +96,24 @@ class Instruction {
                      // Immediates are sign-extended.
 };
 
+// The following class defines one entry of the host translation cache
+// of the simulator (not of the simulated machine): where a virtual page
+// of an address space is in mainMemory, so that ReadMem and WriteMem
+// can skip Translate for pages they have translated before.  It is only
+// filled when a repeated reference needs nothing recorded but the use
+// and dirty bits, so a hit just sets those.
+
+class HostTranslation {
+  public:
+    int vpn;			// virtual page, -1 if the entry is empty
+    int asid;			// address space it belongs to
+    int frame;			// where the page is
+    char *page;			// ... as a host pointer into mainMemory
+    TranslationEntry *pte;	// for the use and dirty bits
+    bool writable;		// FALSE if stores have to trap (read-only
+				// or copy-on-write)
+};
+
 // The following class defines the simulated host workstation hardware, as 
 // seen by user programs -- the CPU registers, main memory, etc.
 // User programs shouldn't be able to tell that they are running on our 
@@ -124,6 +146,16 @@ class Machine {
 
     void OneInstruction(Instruction *instr); 	
     				// Run one instruction of a user program.
+    void ExecuteInstruction(Instruction *instr);
+				// Run an instruction that has already
+				// been fetched and decoded.
+    void RunTranslated();	// Run the user program a basic block at
+				// a time (the "-engine 1" engine)
+    void StartInstruction();	// Count and time one user instruction,
+    void FinishInstruction();	// either one tick at a time or in
+				// batches up to the next interrupt
+    void SettleClock();		// Bring the clock and instruction count
+				// up to date before entering the kernel
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
     
@@ -140,13 +172,43 @@ class Machine {
     				// and return an exception code if the 
 				// translation couldn't be completed.
 
+    void NoteAccess(TranslationEntry *entry, unsigned int pageFrame,
+		    bool writing);
+				// Set the use/dirty bits and the page
+				// replacement state after a successful
+				// translation.
+
     int GetPA (unsigned vaddr); // Returns the physical address corresponding
                                 // to the passed virtual address.
 
+    void EnableTLB(int size, int ways);
+				// Translate through a TLB of "size"
+				// entries, "ways"-way set associative,
+				// instead of the page table
+    void LoadTLB(int vpn, TranslationEntry *pte);
+				// TLB refill: cache the translation of
+				// "vpn" for the current address space
+    void InvalidateTranslation(int asid, int vpn);
+				// Forget the translation of "vpn" in
+				// address space "asid", or all of them
+				// if "vpn" is -1, in the TLB and the
+				// host translation cache
+    void InvalidateHostFrame(int frame);
+				// Forget host translations to "frame",
+				// because its next reference has to be
+				// recorded in full
+    void SetASID(int asid) { currentASID = asid; }
+				// The address space now running
+
     void RaiseException(ExceptionType which, int badVAddr);
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
 
+    void InvalidateDecodedFrame(int frame);
+				// Forget the predecoded instructions of a
+				// physical page, because its contents are
+				// about to be replaced.
+
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state 
 
@@ -159,11 +221,12 @@ class Machine {
 
     char *mainMemory;		// physical memory to store user program,
 				// code and data, while executing
-    int* PIDatPhysAddr;
-    bool* shared;
-    int* PhysToVirtual;
-    unsigned long int* TimeStamp;
-    bool* ReferenceBitSet;
+    FrameTable *frameTable;	// who owns each frame of mainMemory,
+				// and the page replacement state
+
+    Instruction *decodedInstr;	// predecoded copy of each word of
+				// mainMemory, indexed by physAddr / 4
+    bool *decodedValid;		// is the matching decodedInstr current?
  
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
@@ -188,21 +251,48 @@ class Machine {
 
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int tlbSize, tlbWays;		// entries, and entries per set
 
     TranslationEntry *KernelPageTable;
     unsigned int KernelPageTableSize;
 
   private:
+    HostTranslation hostCache[HostCacheSize];	// direct mapped, by vpn
+    void FillHostCache(int vpn, TranslationEntry *pte, int frame);
+
+    int *tlbASID;		// address space each TLB entry belongs to
+    TranslationEntry **tlbSource;	// page table entry each TLB entry was
+				// loaded from: the use and dirty bits
+				// are written through to it
+    int *tlbHand;		// next way to replace, in each set
+    int currentASID;		// tag of the running address space
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
+
+    Instruction *DecodeSlot(int slot);	// decoded word at physAddr slot*4
+    void TranslateBlock(int slot);	// find the basic block at a slot
+    int *blockLength;		// length of the translated block that
+				// starts at each word, 0 if none
+    int translationEpoch;	// bumped whenever decoded code is thrown
+				// away, so a running block can notice
+
+    bool batchClock;		// advance the clock in batches?
+    int unsettledTicks;		// user ticks not yet added to stats
+    int unsettledInstrs;	// instructions not yet added to the
+				// current thread's count
+    int clockDeadline;		// time of the next pending interrupt
 };
 
 extern void ExceptionHandler(ExceptionType which);
 				// Entry point into Nachos for handling
 				// user system calls and exceptions
 				// Defined in exception.cc
+extern void PrintSyscallStatistics();
+				// Calls and ticks of each system call,
+				// also in exception.cc
 
 
 // Routines for converting Words and Short Words to and from the
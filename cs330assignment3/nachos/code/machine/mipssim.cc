@@ -36,12 +36,236 @@ Machine::Run()
         printf("Starting thread \"%s\" at time %d\n",
 	       currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
+
+    // Unless we have to stop after every instruction, run straight up
+    // to the next interrupt deadline and only then advance the clock.
+    batchClock = !singleStep && !DebugIsEnabled('i') && !clockReference;
+    clockDeadline = interrupt->NextDueTime();
+
+    if (executionEngine == TRANSLATOR_ENGINE) {
+	ASSERT(tlb == NULL);		// main rejects -engine 1 with -tlb
+	RunTranslated();		// never returns
+    }
     for (;;) {
-        currentThread->IncInstructionCount();
+        StartInstruction();
         OneInstruction(instr);
+	FinishInstruction();
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::StartInstruction
+// 	Count the user instruction we are about to execute.  In batch
+//	mode the count is only handed to the thread by SettleClock.
+//----------------------------------------------------------------------
+
+void
+Machine::StartInstruction()
+{
+    if (batchClock)
+	unsettledInstrs++;
+    else
+        currentThread->IncInstructionCount();
+}
+
+//----------------------------------------------------------------------
+// Machine::FinishInstruction
+// 	Account for the tick taken by the user instruction just executed.
+//
+//	Without batching, this is just OneTick.  Otherwise we only
+//	remember the tick, until the instruction at which the earliest
+//	pending interrupt comes due; then the whole batch is added to
+//	the clock at once and the interrupt is fired, exactly when the
+//	per-instruction path would have fired it.  Nothing can be
+//	scheduled in between without going through the kernel, which
+//	settles the clock first (see RaiseException).
+//
+//	"-clockref" turns batching off, so that the same program can be
+//	run both ways: with "-clockcheck", the two runs must print the
+//	same trace of interrupts and kernel entries ("make clockcheck" in
+//	userprog runs and compares them).
+//----------------------------------------------------------------------
+
+void
+Machine::FinishInstruction()
+{
+    int ticks;
+
+    if (!batchClock) {
 	interrupt->OneTick();
 	if (singleStep && (runUntilTime <= stats->totalTicks))
 	  Debugger();
+	return;
+    }
+
+    unsettledTicks++;
+    if (stats->totalTicks + unsettledTicks * UserTick < clockDeadline)
+	return;
+
+    currentThread->AddInstructionCount(unsettledInstrs);
+    ticks = unsettledTicks;
+    unsettledTicks = unsettledInstrs = 0;
+    DEBUG('k', "Clock batch of %d ticks, interrupt due at %d\n",
+	  ticks, clockDeadline);
+    interrupt->UserTicks(ticks);	// may switch to another thread
+
+    clockDeadline = interrupt->NextDueTime();
+}
+
+//----------------------------------------------------------------------
+// Machine::SettleClock
+// 	Add the ticks and instructions of the current batch to the
+//	simulated clock and the current thread, so the kernel sees the
+//	same state as after a tick by tick run: all instructions up to
+//	and including the current one counted, and the ticks of all but
+//	the current one elapsed.
+//----------------------------------------------------------------------
+
+void
+Machine::SettleClock()
+{
+    if (!batchClock)
+	return;
+    currentThread->AddInstructionCount(unsettledInstrs);
+    stats->totalTicks += unsettledTicks * UserTick;
+    stats->userTicks += unsettledTicks * UserTick;
+    unsettledTicks = unsettledInstrs = 0;
+}
+
+//----------------------------------------------------------------------
+// IsControlTransfer
+// 	Does this instruction have a branch delay slot?
+//----------------------------------------------------------------------
+
+static bool
+IsControlTransfer(int opCode)
+{
+    switch (opCode) {
+      case OP_BEQ:
+      case OP_BGEZ:
+      case OP_BGEZAL:
+      case OP_BGTZ:
+      case OP_BLEZ:
+      case OP_BLTZ:
+      case OP_BLTZAL:
+      case OP_BNE:
+      case OP_J:
+      case OP_JAL:
+      case OP_JALR:
+      case OP_JR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::DecodeSlot
+// 	Return the predecoded form of the word at physical address
+//	slot * 4, decoding it first if it is not already cached.
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::DecodeSlot(int slot)
+{
+    if (!decodedValid[slot]) {
+	decodedInstr[slot].value =
+		WordToHost(*(unsigned int *) &mainMemory[slot << 2]);
+	decodedInstr[slot].Decode();
+	decodedValid[slot] = TRUE;
+    }
+    return &decodedInstr[slot];
+}
+
+//----------------------------------------------------------------------
+// Machine::TranslateBlock
+// 	Build the basic block that starts at physical word "slot".
+//	A block is a run of consecutive predecoded instructions in one
+//	physical page; it ends with the delay slot of the first branch
+//	or jump, with a syscall or illegal instruction, or at the end
+//	of the page.  The block is remembered by its length, stored
+//	at blockLength[slot].
+//----------------------------------------------------------------------
+
+void
+Machine::TranslateBlock(int slot)
+{
+    int first = slot;
+    int pageEnd = (slot / (PageSize / 4) + 1) * (PageSize / 4);
+    int opCode;
+
+    for (; slot < pageEnd; slot++) {
+	opCode = DecodeSlot(slot)->opCode;
+	if ((opCode == OP_SYSCALL) || (opCode == OP_RFE) ||
+		(opCode == OP_UNIMP) || (opCode == OP_RES))
+	    break;
+	if (IsControlTransfer(opCode)) {
+	    if (slot + 1 < pageEnd) 		// take the delay slot along
+		DecodeSlot(++slot);
+	    break;
+	}
+    }
+    if (slot == pageEnd)
+	slot--;
+    blockLength[first] = slot - first + 1;
+    DEBUG('m', "Translated block at 0x%x, %d instructions\n",
+	  first << 2, blockLength[first]);
+}
+
+//----------------------------------------------------------------------
+// Machine::RunTranslated
+// 	The basic-block execution engine, selected with "-engine 1".
+//	Instead of fetching and decoding every instruction, we
+//	translate the PC once per block and then run the block's
+//	predecoded instructions back to back.
+//
+//	Each instruction still goes through ExecuteInstruction and is
+//	followed by a clock tick, so delayed loads, branch delay slots,
+//	interrupts and exception PCs behave exactly as in the
+//	interpreter.  We leave the block as soon as the PC is not the
+//	next instruction of the block (a taken branch or an exception
+//	that must be retried), or when the kernel has replaced a frame
+//	or written over decoded code in the meantime.
+//----------------------------------------------------------------------
+
+void
+Machine::RunTranslated()
+{
+    int physAddr, slot, length, startPC, epoch, i;
+    unsigned int frame;
+    ExceptionType exception;
+    TranslationEntry *entry;
+
+    for (;;) {
+	// translating the PC is the fetch of the first instruction
+	StartInstruction();
+	startPC = registers[PCReg];
+	exception = Translate(startPC, &physAddr, 4, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, startPC);
+	    FinishInstruction();
+	    continue;
+	}
+	slot = physAddr >> 2;
+	if (blockLength[slot] == 0)
+	    TranslateBlock(slot);
+	length = blockLength[slot];
+	frame = physAddr / PageSize;
+	entry = &KernelPageTable[(unsigned) startPC / PageSize];
+	epoch = translationEpoch;
+
+	for (i = 0;;) {
+	    ExecuteInstruction(&decodedInstr[slot + i]);
+	    FinishInstruction();
+	    i++;
+	    if ((i == length) || (epoch != translationEpoch) ||
+		    (registers[PCReg] != startPC + IndexToAddr(i)))
+		break;
+
+	    // fetch the next instruction of the block
+	    StartInstruction();
+	    NoteAccess(entry, frame, FALSE);
+	}
     }
 }
 
@@ -94,17 +318,38 @@ TypeToReg(RegType reg, Instruction *instr)
 void
 Machine::OneInstruction(Instruction *instr)
 {
-    int raw;
+    int physAddr;
+    ExceptionType exception;
+
+    // Fetch instruction.  The word is only decoded the first time it is
+    // fetched from this physical location; after that we reuse the
+    // predecoded copy, until the frame is replaced or written.
+    exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+    if (exception != NoException) {
+	RaiseException(exception, registers[PCReg]);
+	return;			// exception occurred
+    }
+    ExecuteInstruction(DecodeSlot(physAddr >> 2));
+}
+
+//----------------------------------------------------------------------
+// Machine::ExecuteInstruction
+// 	Execute one already fetched and decoded instruction, the one
+//	at registers[PCReg].  Shared by the interpreter and the
+//	basic-block engine.
+//
+//	The decoded instruction is not looked at again once we have
+//	trapped to the kernel, so it does not matter if the kernel
+//	invalidates it while handling the exception.
+//----------------------------------------------------------------------
+
+void
+Machine::ExecuteInstruction(Instruction *instr)
+{
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
 
-    // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
-	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
-
     if (DebugIsEnabled('m')) {
        struct OpString *str = &opStrings[instr->opCode];
 
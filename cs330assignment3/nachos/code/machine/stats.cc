@@ -36,6 +36,21 @@ Statistics::Statistics()
     burstEstimateError = 0;
 
     pageFaults = 0;
+    recencyHits = frequencyHits = ghostHits = ghostMisses = 0;
+    minorFaults = majorFaults = majorFaultTicks = 0;
+    codeFaults = initDataFaults = uninitDataFaults = stackFaults = 0;
+    tlbHits = tlbMisses = tlbInvalidations = tlbFlushes = 0;
+    hostCacheHits = hostCacheMisses = 0;
+    prefetchedPages = prefetchHits = prefetchWasted = 0;
+    loadControlSuspensions = loadControlReactivations = 0;
+    pageoutReclaims = pageoutCleans = 0;
+    framesZeroed = zeroPoolHits = zeroPoolMisses = 0;
+    cowSharedPages = cowCopies = 0;
+    swapIns = swapOuts = 0;
+    pageCacheHits = pageCacheMisses = 0;
+
+    sleepQueueMaxDepth = sleepWakeups = 0;
+    sleepLatenessTotal = sleepLatenessMax = 0;
 }
 
 //----------------------------------------------------------------------
@@ -53,6 +68,29 @@ Statistics::Print()
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", pageFaults);
+    printf("TLB: hits %d, misses %d, entries invalidated %d, flushes %d\n",
+	tlbHits, tlbMisses, tlbInvalidations, tlbFlushes);
+    printf("Host translation cache: hits %d, page table translations %d\n",
+	hostCacheHits, hostCacheMisses);
+    printf("ARC/2Q: hits recent %d, frequent %d; ghost hits %d, misses %d\n",
+	recencyHits, frequencyHits, ghostHits, ghostMisses);
+    printf("Faults: minor %d, major %d, major fault ticks %d\n", minorFaults,
+	majorFaults, majorFaultTicks);
+    printf("Faults by segment: code %d, initialized data %d, uninitialized data %d, stack %d\n",
+	codeFaults, initDataFaults, uninitDataFaults, stackFaults);
+    printf("Fault-around: pages read ahead %d, used %d, evicted unused %d\n",
+	prefetchedPages, prefetchHits, prefetchWasted);
+    printf("Load control: suspensions %d, reactivations %d\n",
+	loadControlSuspensions, loadControlReactivations);
+    printf("Page-out daemon: pages reclaimed %d, cleaned %d\n",
+	pageoutReclaims, pageoutCleans);
+    printf("Zeroed frames: zeroed while idle %d, zero-fill faults served %d, cleared on fault %d\n",
+	framesZeroed, zeroPoolHits, zeroPoolMisses);
+    printf("Copy-on-write: pages shared %d, copied %d\n", cowSharedPages, cowCopies);
+    printf("Swap: pages in %d, out %d\n", swapIns, swapOuts);
+    printf("Page cache: hits %d, misses %d\n", pageCacheHits, pageCacheMisses);
+    printf("Sleep queue: max depth %d, wakeups %d, lateness total %d, max %d\n",
+	sleepQueueMaxDepth, sleepWakeups, sleepLatenessTotal, sleepLatenessMax);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
 
@@ -52,6 +52,45 @@ class Statistics {
     int numPacketsRecvd;	// number of packets received over the network
 
     int pageFaults;
+    int recencyHits;		// ARC/2Q: references to pages on T1/A1in
+    int frequencyHits;		// ... and on T2/Am
+    int ghostHits;		// ARC/2Q: faults on pages recently evicted
+    int ghostMisses;		// ... and on the others
+    int minorFaults;		// Faults served without I/O
+    int hostCacheHits;		// ReadMem/WriteMem served by the host
+				// translation cache
+    int hostCacheMisses;	// Translations through the page table
+    int tlbHits;		// Translations found in the TLB
+    int tlbMisses;		// ... not found, so refilled by the kernel
+    int tlbInvalidations;	// TLB entries dropped by the kernel
+    int tlbFlushes;		// ... all of an address space at once
+    int codeFaults;		// Faults by segment of the faulting page
+    int initDataFaults;
+    int uninitDataFaults;
+    int stackFaults;
+    int majorFaults;		// Faults that read the page in
+    int majorFaultTicks;	// Ticks spent in major faults, summed
+    int prefetchedPages;	// Pages read ahead by fault-around
+    int prefetchHits;		// ... that were then used
+    int prefetchWasted;		// ... that were evicted unused
+    int loadControlSuspensions;	// processes deactivated by load control
+    int loadControlReactivations;	// ... and brought back
+    int pageoutReclaims;	// pages evicted by the page-out daemon
+    int pageoutCleans;		// dirty pages it wrote out ahead of time
+    int framesZeroed;		// free frames zeroed while idle
+    int zeroPoolHits;		// zero-fill pages given one of them
+    int zeroPoolMisses;		// ... and cleared on the fault path
+    int cowSharedPages;		// Pages shared copy-on-write by fork
+    int cowCopies;		// Shared pages copied on the first write
+    int swapIns;		// Pages read back from the swap disk
+    int swapOuts;		// Evicted pages written to the swap disk
+    int pageCacheHits;		// Faults on executable pages already cached
+    int pageCacheMisses;	// ... and on those read from the executable
+
+    int sleepQueueMaxDepth;	// Most threads asleep at once
+    int sleepWakeups;		// Threads woken up from the sleep queue
+    int sleepLatenessTotal;	// Ticks between due time and wakeup, summed
+    int sleepLatenessMax;	// ... and the worst case
 
     Statistics(); 		// initialize everything to zero
 
@@ -22,6 +22,13 @@
 //
 //	Note that the contents of the TLB are specific to an address space.
 //	If the address space changes, so does the contents of the TLB!
+//	Here each entry is tagged with the address space it belongs to
+//	(its ASID, the pid), so a context switch only changes the tag
+//	that matches, instead of flushing the TLB.
+//
+//	The TLB is "tlbWays"-way set associative: the translation of
+//	virtual page "vpn" can only be in set vpn % (tlbSize / tlbWays),
+//	so a lookup only searches that set.
 //
 // DO NOT CHANGE -- part of the machine emulation
 //
@@ -79,6 +86,9 @@ ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 //   	Returns FALSE if the translation step from virtual to physical memory
 //   	failed.
 //
+//	An aligned read of a page in the host translation cache loads
+//	straight from the host pointer.
+//
 //	"addr" -- the virtual address to read from
 //	"size" -- the number of bytes to read (1, 2, or 4)
 //	"value" -- the place to write the result
@@ -90,6 +100,22 @@ Machine::ReadMem(int addr, int size, int *value)
   int data;
   ExceptionType exception;
   int physicalAddress;
+  unsigned vpn = (unsigned) addr / PageSize;
+  HostTranslation *h = &hostCache[vpn % HostCacheSize];
+  char *p;
+
+  if ((h->vpn == (int) vpn) && (h->asid == currentASID) && !(addr & (size - 1))) {
+    h->pte->use = TRUE;
+    p = h->page + (unsigned) addr % PageSize;
+    if (size == 4)
+      *value = WordToHost(*(unsigned int *) p);
+    else if (size == 2)
+      *value = ShortToHost(*(unsigned short *) p);
+    else
+      *value = *p;
+    stats->hostCacheHits++;
+    return TRUE;
+  }
 
   DEBUG('a', "Reading VA 0x%x, size %d\n", addr, size);
 
@@ -129,6 +155,9 @@ Machine::ReadMem(int addr, int size, int *value)
 //   	Returns FALSE if the translation step from virtual to physical memory
 //   	failed.
 //
+//	An aligned write to a writable page in the host translation
+//	cache stores straight through the host pointer.
+//
 //	"addr" -- the virtual address to write to
 //	"size" -- the number of bytes to be written (1, 2, or 4)
 //	"value" -- the data to be written
@@ -139,6 +168,27 @@ Machine::WriteMem(int addr, int size, int value)
 {
   ExceptionType exception;
   int physicalAddress;
+  unsigned vpn = (unsigned) addr / PageSize;
+  HostTranslation *h = &hostCache[vpn % HostCacheSize];
+  char *p;
+
+  if ((h->vpn == (int) vpn) && (h->asid == currentASID) && h->writable
+      && !(addr & (size - 1))) {
+    h->pte->use = TRUE;
+    h->pte->dirty = TRUE;
+    physicalAddress = h->frame * PageSize + (unsigned) addr % PageSize;
+    if (decodedValid[physicalAddress >> 2])
+      InvalidateDecodedFrame(h->frame);
+    p = h->page + (unsigned) addr % PageSize;
+    if (size == 4)
+      *(unsigned int *) p = WordToMachine((unsigned int) value);
+    else if (size == 2)
+      *(unsigned short *) p = ShortToMachine((unsigned short) (value & 0xffff));
+    else
+      *p = (unsigned char) (value & 0xff);
+    stats->hostCacheHits++;
+    return TRUE;
+  }
 
   DEBUG('a', "Writing VA 0x%x, size %d, value 0x%x\n", addr, size, value);
 
@@ -147,6 +197,9 @@ Machine::WriteMem(int addr, int size, int value)
     machine->RaiseException(exception, addr);
     return FALSE;
   }
+  // the word may hold an instruction we have already decoded
+  if (decodedValid[physicalAddress >> 2])
+    InvalidateDecodedFrame(physicalAddress / PageSize);
   switch (size) {
     case 1:
       machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
@@ -186,9 +239,9 @@ Machine::WriteMem(int addr, int size, int value)
   ExceptionType
 Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 {
-  int i;
+  int i, first;
   unsigned int vpn, offset;
-  TranslationEntry *entry;
+  TranslationEntry *entry, *pte;
   unsigned int pageFrame;
 
   DEBUG('a', "\tTranslate 0x%x, %s: ", virtAddr, writing ? "write" : "read");
@@ -199,8 +252,8 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     return AddressErrorException;
   }
 
-  // we must have either a TLB or a page table, but not both!
-  ASSERT(tlb == NULL || KernelPageTable == NULL);	
+  // we must have a TLB or a page table; with a TLB, the page table is
+  // only used by the kernel, to refill the TLB
   ASSERT(tlb != NULL || KernelPageTable != NULL);	
 
   // calculate the virtual page number, and offset within the page,
@@ -209,6 +262,7 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
   offset = (unsigned) virtAddr % PageSize;
 
   if (tlb == NULL) {		// => page table => vpn is index into table
+    stats->hostCacheMisses++;
     if (vpn >= KernelPageTableSize) {
       DEBUG('q', "virtual page # %d too large for page table size %d!\n", 
           virtAddr, KernelPageTableSize);
@@ -218,19 +272,24 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
           virtAddr, KernelPageTableSize);
       return PageFaultException;
     }
-    entry = &KernelPageTable[vpn];
+    entry = pte = &KernelPageTable[vpn];
   } else {
-    for (entry = NULL, i = 0; i < TLBSize; i++)
-      if (tlb[i].valid && (tlb[i].virtualPage == vpn)) {
+    first = (vpn % (tlbSize / tlbWays)) * tlbWays;
+    for (entry = pte = NULL, i = first; i < first + tlbWays; i++)
+      if (tlb[i].valid && (tlb[i].virtualPage == (int)vpn)
+          && (tlbASID[i] == currentASID)) {
         entry = &tlb[i];			// FOUND!
+        pte = tlbSource[i];
         break;
       }
     if (entry == NULL) {				// not found
       DEBUG('r', "*** no valid TLB entry found for this virtual page!\n");
+      stats->tlbMisses++;
       return PageFaultException;		// really, this is a TLB fault,
       // the page may be in memory,
       // but not in the TLB
     }
+    stats->tlbHits++;
   }
 
   if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -245,15 +304,49 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     DEBUG('a', "*** frame %d > %d!\n", pageFrame, NumPhysPages);
     return BusErrorException;
   }
+  NoteAccess(pte, pageFrame, writing);
+  FillHostCache(vpn, pte, pageFrame);
+  *physAddr = pageFrame * PageSize + offset;
+  ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
+  DEBUG('a', "phys addr = 0x%x\n", *physAddr);
+  return NoException;
+}
+
+//----------------------------------------------------------------------
+// Machine::NoteAccess
+// 	Record a reference to a resident page: set the use and dirty
+//	bits in its translation entry, and the per-frame state the page
+//	replacement algorithm looks at, and the reference itself if a
+//	trace is being recorded.  Called by Translate, and by the
+//	basic-block engine for the instruction fetches it does not
+//	translate one by one.
+//----------------------------------------------------------------------
+
+  void
+Machine::NoteAccess(TranslationEntry *entry, unsigned int pageFrame, bool writing)
+{
   entry->use = TRUE;		// set the use, dirty bits
 
+  if (referenceTrace != NULL)
+    referenceTrace->Record(currentThread->GetPID(), entry->virtualPage, writing);
+
   //-------------------------------------------------------------------------------
   //-------------------------------------------------------------------------------
   // for page replacement Algos
   if (pageReplacementAlgo == LRU)
-    machine->TimeStamp[pageFrame] = stats->totalTicks;
-  else if (pageReplacementAlgo == LRU_CLOCK) {
-    machine->ReferenceBitSet[pageFrame] = true;
+    frameTable->Touch(pageFrame, stats->totalTicks + unsettledTicks * UserTick);
+  else if ((pageReplacementAlgo == LRU_CLOCK) || (pageReplacementAlgo == TWO_HANDED_CLOCK)) {
+    frameTable->Frame(pageFrame)->flags |= FrameReferenced;
+  }
+  else if ((pageReplacementAlgo == ARC) || (pageReplacementAlgo == TWO_Q))
+    adaptiveReplacement->Referenced(pageFrame);
+
+  // a page read ahead by fault-around paid off: widen the window
+  if (frameTable->Frame(pageFrame)->flags & FramePrefetched) {
+    frameTable->Frame(pageFrame)->flags &= ~FramePrefetched;
+    stats->prefetchHits++;
+    if (faultAroundWindow < faultAroundMax)
+      faultAroundWindow++;
   }
 
   //-------------------------------------------------------------------------------
@@ -261,10 +354,51 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 
   if (writing)
     entry->dirty = TRUE;
-  *physAddr = pageFrame * PageSize + offset;
-  ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
-  DEBUG('a', "phys addr = 0x%x\n", *physAddr);
-  return NoException;
+}
+
+//----------------------------------------------------------------------
+// Machine::FillHostCache
+// 	Remember where page "vpn", mapped by "pte" to "frame", is in
+//	mainMemory, if its next references can take the fast path of
+//	ReadMem and WriteMem: that is, if all they have to record is the
+//	use and dirty bits.  It is not so with a TLB, whose misses are
+//	being counted, nor when every reference is traced, or moves the
+//	page in the LRU, ARC or 2Q order.  With the clock algorithms it
+//	is so until the hand clears the frame's reference bit, which
+//	calls InvalidateHostFrame.
+//----------------------------------------------------------------------
+
+  void
+Machine::FillHostCache(int vpn, TranslationEntry *pte, int frame)
+{
+  HostTranslation *h = &hostCache[vpn % HostCacheSize];
+
+  if ((tlb != NULL) || (referenceTrace != NULL) || DebugIsEnabled('a')
+      || (pageReplacementAlgo == LRU) || (pageReplacementAlgo == ARC)
+      || (pageReplacementAlgo == TWO_Q))
+    return;
+  h->vpn = vpn;
+  h->asid = currentASID;
+  h->frame = frame;
+  h->page = &mainMemory[frame * PageSize];
+  h->pte = pte;
+  h->writable = !pte->readOnly;
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateHostFrame
+// 	The next reference to "frame" has to go through Translate: drop
+//	the host translations to it.
+//----------------------------------------------------------------------
+
+  void
+Machine::InvalidateHostFrame(int frame)
+{
+  int i;
+
+  for (i = 0; i < HostCacheSize; i++)
+    if ((hostCache[i].vpn != -1) && (hostCache[i].frame == frame))
+      hostCache[i].vpn = -1;
 }
 
 //----------------------------------------------------------------------
@@ -291,3 +425,107 @@ Machine::GetPA (unsigned vaddr)
   }
   else return -1;
 }
+
+//----------------------------------------------------------------------
+// Machine::EnableTLB
+//      Translate user addresses through a TLB from now on, with every
+//      entry empty.  The kernel fills it on PageFaultException, with
+//      LoadTLB.
+//
+//	"size" -- the number of entries
+//	"ways" -- the entries in each set: 1 for direct mapped, "size"
+//		for fully associative
+//----------------------------------------------------------------------
+
+  void
+Machine::EnableTLB(int size, int ways)
+{
+  int i;
+
+  ASSERT((size > 0) && (size <= MaxTLBSize));
+  ASSERT((ways > 0) && (size % ways == 0));
+  tlbSize = size;
+  tlbWays = ways;
+  tlb = new TranslationEntry[tlbSize];
+  tlbASID = new int[tlbSize];
+  tlbSource = new TranslationEntry *[tlbSize];
+  tlbHand = new int[tlbSize / tlbWays];
+  for (i = 0; i < tlbSize; i++) {
+    tlb[i].valid = FALSE;
+    tlbASID[i] = -1;
+    tlbSource[i] = NULL;
+  }
+  for (i = 0; i < tlbSize / tlbWays; i++)
+    tlbHand[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// Machine::LoadTLB
+//      Called by the kernel on a TLB miss: copy the page table entry
+//      "pte" of virtual page "vpn" of the current address space into
+//      the set of "vpn", in an empty way if there is one, otherwise in
+//      the way after the one loaded last (round robin).
+//
+//	Only the translation is copied; the use and dirty bits are kept
+//	in "pte", so the replaced entry has nothing to write back.
+//----------------------------------------------------------------------
+
+  void
+Machine::LoadTLB(int vpn, TranslationEntry *pte)
+{
+  int set = vpn % (tlbSize / tlbWays);
+  int first = set * tlbWays;
+  int i, slot = -1;
+
+  ASSERT(tlb != NULL);
+  for (i = first; i < first + tlbWays; i++)
+    if (!tlb[i].valid) {
+      slot = i;
+      break;
+    }
+  if (slot == -1) {
+    slot = first + tlbHand[set];
+    tlbHand[set] = (tlbHand[set] + 1) % tlbWays;
+  }
+  DEBUG('r', "TLB refill: asid %d, vpn %d -> frame %d, in entry %d\n",
+	currentASID, vpn, pte->physicalPage, slot);
+  tlb[slot] = *pte;
+  tlbASID[slot] = currentASID;
+  tlbSource[slot] = pte;
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateTranslation
+//      The kernel changed the translation of page "vpn" of address
+//      space "asid" (evicted it, made it writable, ...): drop it from
+//      the host translation cache, and from the TLB, so the next
+//      reference refills it.  A "vpn" of -1 drops every entry of
+//      "asid", for when its page table goes away.
+//----------------------------------------------------------------------
+
+  void
+Machine::InvalidateTranslation(int asid, int vpn)
+{
+  int i, first, last;
+
+  for (i = 0; i < HostCacheSize; i++)
+    if ((hostCache[i].asid == asid) && ((vpn == -1) || (hostCache[i].vpn == vpn)))
+      hostCache[i].vpn = -1;
+  if (tlb == NULL)
+    return;
+  if (vpn == -1) {
+    first = 0;
+    last = tlbSize;
+    stats->tlbFlushes++;
+  } else {
+    first = (vpn % (tlbSize / tlbWays)) * tlbWays;
+    last = first + tlbWays;
+  }
+  for (i = first; i < last; i++)
+    if (tlb[i].valid && (tlbASID[i] == asid)
+        && ((vpn == -1) || (tlb[i].virtualPage == vpn))) {
+      tlb[i].valid = FALSE;
+      tlbSource[i] = NULL;
+      stats->tlbInvalidations++;
+    }
+}
@@ -44,6 +44,8 @@ class TranslationEntry {
     bool shared;        // This bit implies that the page is shared, it 
       // will help in the fork call
     bool backup;        // whether to reead  from swap or main memory
+    bool copyOnWrite;   // The frame is shared with a forked address
+      // space; readOnly is set until the first write copies it
 };
 
 #endif
@@ -0,0 +1,61 @@
+/* ringtest.c
+ *	Print in a loop, like testloop, but through the syscall rings:
+ *	the prints are queued, and run a ringful at a time by one
+ *	RingEnter trap each.
+ */
+
+#include "syscall.h"
+#define OUTER_BOUND 40
+#define ENTRIES 32
+
+RingHeader *ring;
+
+void
+Queue(int type, int arg)
+{
+    RingRequest *request;
+
+    if (ring->sqTail - ring->sqHead == ring->entries) {
+       syscall_wrapper_RingEnter(0);		/* make room */
+       ring->cqHead = ring->cqTail;		/* results not needed */
+    }
+    request = RingSubmission(ring, ring->sqTail);
+    request->type = type;
+    request->arg = arg;
+    request->userData = ring->sqTail;
+    ring->sqTail++;
+}
+
+int
+main()
+{
+    int k, traps = 0, pid = syscall_wrapper_GetPID();
+    unsigned start_time, end_time;
+
+    ring = syscall_wrapper_RingSetup(ENTRIES);
+    if (ring == 0) {
+       syscall_wrapper_PrintString("RingSetup failed\n");
+       return 1;
+    }
+
+    start_time = syscall_wrapper_GetTime();
+    for (k=0; k<OUTER_BOUND; k++) {
+       Queue(SysCall_PrintInt, pid);
+       Queue(SysCall_PrintChar, ' ');
+       if (ring->sqTail - ring->sqHead == ring->entries) traps++;
+    }
+    Queue(SysCall_Time, 0);
+    syscall_wrapper_RingEnter(0);
+    traps++;
+    end_time = RingCompletionEntry(ring, ring->cqTail - 1)->result;
+
+    syscall_wrapper_PrintChar('\n');
+    syscall_wrapper_PrintString("Requests: ");
+    syscall_wrapper_PrintInt(2*OUTER_BOUND + 1);
+    syscall_wrapper_PrintString(", RingEnter traps: ");
+    syscall_wrapper_PrintInt(traps);
+    syscall_wrapper_PrintString(", Total time: ");
+    syscall_wrapper_PrintInt(end_time-start_time);
+    syscall_wrapper_PrintChar('\n');
+    return 0;
+}
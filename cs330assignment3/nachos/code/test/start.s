@@ -274,6 +274,22 @@ syscall_wrapper_ShmAllocate:
         j       $31
         .end syscall_wrapper_ShmAllocate
 
+        .globl syscall_wrapper_RingSetup
+        .ent    syscall_wrapper_RingSetup
+syscall_wrapper_RingSetup:
+	addiu $2,$0,SysCall_RingSetup
+        syscall
+        j       $31
+        .end syscall_wrapper_RingSetup
+
+        .globl syscall_wrapper_RingEnter
+        .ent    syscall_wrapper_RingEnter
+syscall_wrapper_RingEnter:
+	addiu $2,$0,SysCall_RingEnter
+        syscall
+        j       $31
+        .end syscall_wrapper_RingEnter
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
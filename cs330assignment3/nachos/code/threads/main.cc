@@ -19,11 +19,22 @@
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
+//    -qb <n> times the pending interrupt queue with n events
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
 //    -c tests the console
+//    -engine picks the interpreter (0) or the basic-block translator (1);
+//	the translator needs a page table, so it cannot be used with -tlb
+//    -clockcheck traces every interrupt and kernel entry, with the time
+//    -clockref ticks the clock once per instruction instead of in batches
+//	("make clockcheck" in userprog compares the traces of both clocks)
+//    -T <unix file> records every page reference, for userprog/pagesim
+//    -lc deactivates processes whose working sets do not fit in memory
+//    -pd starts the page-out daemon, which keeps some frames free
+//    -tlb <n> translates through a TLB of n entries, refilled by the kernel
+//    -tlbways <n> makes the TLB n-way set associative (default: fully)
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
@@ -62,6 +73,7 @@ extern void LaunchUserProcess(char *file), ConsoleTest(char *in, char *out);
 extern void MailTest(int networkID);
 
 extern void ReadInputAndFork(char *file);
+extern void InterruptQueueBenchmark(int numEvents);
 
 //----------------------------------------------------------------------
 // main
@@ -96,6 +108,11 @@ main(int argc, char **argv)
 	argCount = 1;
         if (!strcmp(*argv, "-z"))               // print copyright
             printf (copyright);
+        if (!strcmp(*argv, "-qb")) {		// time the interrupt queue
+	    ASSERT(argc > 1);
+            InterruptQueueBenchmark(atoi(*(argv + 1)));
+            argCount = 2;
+        }
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-A")) {		// read scheduling algorithm
            schedulingAlgo = atoi(*(argv + 1));
@@ -112,7 +129,27 @@ main(int argc, char **argv)
         } else if (!strcmp(*argv, "-R")) {
             pageReplacementAlgo = atoi(*(argv + 1));
             argCount = 2;
-            ASSERT(pageReplacementAlgo >= 0 && pageReplacementAlgo <= 4);
+            ASSERT(pageReplacementAlgo >= 0 && pageReplacementAlgo <= TWO_Q);
+        } else if (!strcmp(*argv, "-fa")) {	// fault-around window,
+            faultAroundMax = atoi(*(argv + 1));	// 1 = off
+            argCount = 2;
+            ASSERT((faultAroundMax >= 1) && (faultAroundMax <= MAX_FAULT_AROUND));
+            faultAroundWindow = faultAroundMax;
+        } else if (!strcmp(*argv, "-engine")) {	// 0 = interpreter,
+            executionEngine = atoi(*(argv + 1));	// 1 = block translator
+            argCount = 2;
+            ASSERT((executionEngine == INTERPRETER_ENGINE) ||
+                   (executionEngine == TRANSLATOR_ENGINE));
+            if ((executionEngine == TRANSLATOR_ENGINE) && (machine->tlb != NULL)) {
+                // blocks are found by physical address through the page
+                // table, which the machine does not use with a TLB
+                printf("-engine 1 cannot be used with a TLB; use -engine 0\n");
+                ASSERT(FALSE);
+            }
+        } else if (!strcmp(*argv, "-clockcheck")) {	// trace the clock
+            clockCheck = TRUE;
+        } else if (!strcmp(*argv, "-clockref")) {	// reference clock,
+            clockReference = TRUE;			// one tick at a time
         } else if (!strcmp(*argv, "-P")) {
             schedPriority = atoi(*(argv + 1));
             argCount = 2;
@@ -0,0 +1,270 @@
+// readyqueue.cc
+//	Routines to manage the ready queue of the priority based
+//	schedulers.  See readyqueue.h for an overview.
+//
+//	NOTE: Like the rest of the scheduler, these routines assume that
+//	interrupts are already disabled.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "readyqueue.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// LowestBit
+// 	Number of the lowest bit set in a non-zero word.
+//----------------------------------------------------------------------
+
+static int
+LowestBit(unsigned word)
+{
+    ASSERT(word != 0);
+    return __builtin_ctz(word);
+}
+
+//----------------------------------------------------------------------
+// LevelOf
+// 	The level priority "key" is filed under: the priority itself if
+//	it is small, otherwise its power of two and the SubLevelBits bits
+//	below the leading one.  Larger priorities never get a lower
+//	level.
+//----------------------------------------------------------------------
+
+static int
+LevelOf(int key)
+{
+    int octave;
+
+    ASSERT(key >= 0);
+    if (key < (1 << ExactLevelBits))
+	return key;
+    octave = 31 - __builtin_clz(key);	// ExactLevelBits and up
+    return (1 << ExactLevelBits) + ((octave - ExactLevelBits) << SubLevelBits)
+	+ ((key >> (octave - SubLevelBits)) & ((1 << SubLevelBits) - 1));
+}
+
+//----------------------------------------------------------------------
+// Decays
+// 	Can a usage decay still change the priority of a ready thread?
+//	Only under the UNIX scheduler, and only while it has usage left
+//	or is not yet at its base priority.
+//----------------------------------------------------------------------
+
+static bool
+Decays(NachOSThread *thread)
+{
+    return (schedulingAlgo == UNIX_SCHED)
+	&& ((thread->GetUsage() >= 2)
+	    || (thread->GetPriority() != thread->GetBasePriority()));
+}
+
+//----------------------------------------------------------------------
+// PriorityReadyQueue::PriorityReadyQueue
+// 	Initialize the queue, empty to start with.
+//----------------------------------------------------------------------
+
+PriorityReadyQueue::PriorityReadyQueue()
+{
+    int i;
+
+    ASSERT(ReadyMapWords <= 32);
+    ASSERT(LevelOf(0x7fffffff) < NumReadyLevels);
+    for (i = 0; i < NumReadyLevels; i++)
+	levelHead[i] = levelTail[i] = NULL;
+    for (i = 0; i < ReadyMapWords; i++)
+	levelMap[i] = 0;
+    wordMap = 0;
+    decaying = NULL;
+    arrivals = 0;
+    numReady = 0;
+}
+
+//----------------------------------------------------------------------
+// PriorityReadyQueue::~PriorityReadyQueue
+// 	De-allocate the queue.  The threads themselves are not ours.
+//----------------------------------------------------------------------
+
+PriorityReadyQueue::~PriorityReadyQueue()
+{
+}
+
+//----------------------------------------------------------------------
+// PriorityReadyQueue::Append
+// 	Put a thread that has just become ready on the queue, after every
+//	ready thread with the same priority.
+//----------------------------------------------------------------------
+
+void
+PriorityReadyQueue::Append(NachOSThread *thread)
+{
+    thread->readySeq = arrivals++;
+    numReady++;
+    Insert(thread);
+
+    thread->decayPrev = NULL;
+    thread->decayNext = NULL;
+    thread->readyDecays = Decays(thread);
+    if (thread->readyDecays) {
+	thread->decayNext = decaying;
+	if (decaying != NULL)
+	    decaying->decayPrev = thread;
+	decaying = thread;
+    }
+}
+
+//----------------------------------------------------------------------
+// PriorityReadyQueue::RemoveMin
+// 	Take the thread that the scheduler should run next off the queue:
+//	the one with the smallest priority, and among those the one that
+//	has been on the queue the longest.
+//
+// Returns:
+//	The thread, NULL if no thread is ready.
+//----------------------------------------------------------------------
+
+NachOSThread *
+PriorityReadyQueue::RemoveMin()
+{
+    NachOSThread *thread;
+    int word;
+
+    if (numReady == 0)
+	return NULL;
+    word = LowestBit(wordMap);
+    thread = levelHead[word * 32 + LowestBit(levelMap[word])];
+    ASSERT(thread != NULL);
+
+    Remove(thread);
+    StopDecay(thread);
+    numReady--;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// PriorityReadyQueue::Decay
+// 	The usage of every thread has just been halved (see
+//	ProcessScheduler::UpdateThreadPriority).  File the ready threads
+//	whose priority changed under the new one, and forget the ones
+//	whose priority will not change any more.
+//----------------------------------------------------------------------
+
+void
+PriorityReadyQueue::Decay()
+{
+    NachOSThread *thread, *next;
+
+    for (thread = decaying; thread != NULL; thread = next) {
+	next = thread->decayNext;
+	if (thread->GetPriority() != thread->readyKey) {
+	    Remove(thread);
+	    Insert(thread);
+	}
+	if (!Decays(thread))
+	    StopDecay(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// PriorityReadyQueue::Mapcar
+// 	Apply a function to each ready thread, in the order RemoveMin
+//	would take them if no priority changed.
+//----------------------------------------------------------------------
+
+void
+PriorityReadyQueue::Mapcar(VoidFunctionPtr func)
+{
+    NachOSThread *thread;
+    int level;
+
+    for (level = 0; level < NumReadyLevels; level++)
+	for (thread = levelHead[level]; thread != NULL; thread = thread->readyNext)
+	    (*func)((int)thread);
+}
+
+//----------------------------------------------------------------------
+// PriorityReadyQueue::Insert
+// 	File a thread under its current priority, in its place in the
+//	level, by priority and then by order of arrival.  The search goes
+//	back from the end, since threads are usually filed after the
+//	others.
+//----------------------------------------------------------------------
+
+void
+PriorityReadyQueue::Insert(NachOSThread *thread)
+{
+    int key = thread->GetPriority();
+    int level = LevelOf(key);
+    NachOSThread *prev = levelTail[level];
+
+    while ((prev != NULL) && ((key < prev->readyKey) || ((key == prev->readyKey)
+		&& ((int)(thread->readySeq - prev->readySeq) < 0))))
+	prev = prev->readyPrev;
+
+    thread->readyKey = key;
+    thread->readyPrev = prev;
+    if (prev == NULL) {
+	thread->readyNext = levelHead[level];
+	levelHead[level] = thread;
+    } else {
+	thread->readyNext = prev->readyNext;
+	prev->readyNext = thread;
+    }
+    if (thread->readyNext == NULL)
+	levelTail[level] = thread;
+    else
+	thread->readyNext->readyPrev = thread;
+
+    levelMap[level / 32] |= 1u << (level & 31);
+    wordMap |= 1u << (level / 32);
+}
+
+//----------------------------------------------------------------------
+// PriorityReadyQueue::Remove
+// 	Take a thread out of the level it was filed under.
+//----------------------------------------------------------------------
+
+void
+PriorityReadyQueue::Remove(NachOSThread *thread)
+{
+    int level = LevelOf(thread->readyKey);
+
+    if (thread->readyPrev == NULL)
+	levelHead[level] = thread->readyNext;
+    else
+	thread->readyPrev->readyNext = thread->readyNext;
+    if (thread->readyNext == NULL)
+	levelTail[level] = thread->readyPrev;
+    else
+	thread->readyNext->readyPrev = thread->readyPrev;
+    thread->readyPrev = thread->readyNext = NULL;
+
+    if (levelHead[level] == NULL) {
+	levelMap[level / 32] &= ~(1u << (level & 31));
+	if (levelMap[level / 32] == 0)
+	    wordMap &= ~(1u << (level / 32));
+    }
+}
+
+//----------------------------------------------------------------------
+// PriorityReadyQueue::StopDecay
+// 	Take a thread off the list of those whose priority can decay, if
+//	it is on it.
+//----------------------------------------------------------------------
+
+void
+PriorityReadyQueue::StopDecay(NachOSThread *thread)
+{
+    if (!thread->readyDecays)
+	return;
+    if (thread->decayPrev == NULL)
+	decaying = thread->decayNext;
+    else
+	thread->decayPrev->decayNext = thread->decayNext;
+    if (thread->decayNext != NULL)
+	thread->decayNext->decayPrev = thread->decayPrev;
+    thread->decayPrev = thread->decayNext = NULL;
+    thread->readyDecays = FALSE;
+}
@@ -0,0 +1,75 @@
+// readyqueue.h
+//	Data structures for the ready queue of the priority based
+//	schedulers (UNIX_SCHED and NON_PREEMPTIVE_SJF).
+//
+//	The ready threads are kept in levels by priority, with a two
+//	level bitmap of the non-empty levels, so the best thread is found
+//	with two find-first-set operations instead of a scan of the whole
+//	ready list.  Small priorities have a level each; above that the
+//	levels are log-scaled, 32 for each power of two, so that every
+//	priority, however long the SJF burst estimate, has a level.
+//
+//	The ready list this replaces picks the first thread, in order of
+//	arrival, among those with the smallest priority.  Each level is
+//	kept sorted by priority and then by order of arrival, so its
+//	first thread is the one to pick.  A thread arriving goes at the
+//	end of its level, unless it shares a log-scaled level with larger
+//	priorities, which it goes ahead of.
+//
+//	Under the UNIX scheduler, the usage of every ready thread halves
+//	each time the running thread is charged for its burst, and its
+//	priority with it.  Only the threads whose priority can still
+//	change are re-filed: those with some usage left to decay, kept on
+//	a list of their own.  A thread leaves that list after about log2
+//	of its usage decays, so a decay costs nothing for the threads
+//	that have settled at their base priority.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef READYQUEUE_H
+#define READYQUEUE_H
+
+#include "copyright.h"
+#include "thread.h"
+
+#define ExactLevelBits	8			// a level for each priority
+						// below 2^ExactLevelBits
+#define SubLevelBits	5			// 2^SubLevelBits levels for
+						// each power of two above
+#define NumReadyLevels	1024			// enough for any priority
+#define ReadyMapWords	(NumReadyLevels / 32)	// must be at most 32
+
+class PriorityReadyQueue {
+  public:
+    PriorityReadyQueue();		// initialize an empty queue
+    ~PriorityReadyQueue();		// de-allocate the queue
+
+    void Append(NachOSThread *thread);	// file thread under its current
+					// priority, after those before it
+    NachOSThread *RemoveMin();		// take the first thread with the
+					// smallest priority, NULL if none
+    void Decay();			// re-file the ready threads whose
+					// priority a usage decay changed
+    bool IsEmpty() { return (numReady == 0); }
+
+    void Mapcar(VoidFunctionPtr func);	// apply func to every ready thread,
+					// in the order they would be picked
+
+  private:
+    NachOSThread *levelHead[NumReadyLevels];	// threads of each level,
+    NachOSThread *levelTail[NumReadyLevels];	// sorted as above
+    unsigned levelMap[ReadyMapWords];	// bit set for each non-empty level
+    unsigned wordMap;			// bit set for each non-zero levelMap
+    NachOSThread *decaying;		// ready threads whose priority can
+					// still decay
+    unsigned arrivals;			// number the next thread to arrive
+    int numReady;
+
+    void Insert(NachOSThread *thread);	// file thread under its priority
+    void Remove(NachOSThread *thread);	// take it out of its level
+    void StopDecay(NachOSThread *thread);	// take it off "decaying"
+};
+
+#endif // READYQUEUE_H
@@ -30,7 +30,9 @@
 ProcessScheduler::ProcessScheduler()
 { 
     listOfReadyThreads = new List;
+    priorityReadyThreads = new PriorityReadyQueue;
     empty_ready_queue_start_time = -1;
+    decayEpoch = 0;
 } 
 
 //----------------------------------------------------------------------
@@ -41,6 +43,7 @@ ProcessScheduler::ProcessScheduler()
 ProcessScheduler::~ProcessScheduler()
 { 
     delete listOfReadyThreads; 
+    delete priorityReadyThreads;
 } 
 
 //----------------------------------------------------------------------
@@ -78,11 +81,17 @@ ProcessScheduler::MoveThreadToReadyQueue (NachOSThread *thread)
     }
     thread->setStatus(READY);
     thread->SetWaitStartTime(stats->totalTicks);
-    if (listOfReadyThreads->IsEmpty() && (empty_ready_queue_start_time != -1)) {
+    if (listOfReadyThreads->IsEmpty() && priorityReadyThreads->IsEmpty()
+                                      && (empty_ready_queue_start_time != -1)) {
        stats->empty_ready_queue_time += (stats->totalTicks - empty_ready_queue_start_time);
        empty_ready_queue_start_time = -1;
     }
-    listOfReadyThreads->Append((void *)thread);
+    if (UsePriorityQueue()) {
+       priorityReadyThreads->Append(thread);
+    }
+    else {
+       listOfReadyThreads->Append((void *)thread);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -96,8 +105,8 @@ ProcessScheduler::MoveThreadToReadyQueue (NachOSThread *thread)
 NachOSThread *
 ProcessScheduler::SelectNextReadyThread ()
 {
-    if ((schedulingAlgo == UNIX_SCHED) || (schedulingAlgo == NON_PREEMPTIVE_SJF)){
-       return (NachOSThread *)listOfReadyThreads->GetMinPriorityThread();
+    if (UsePriorityQueue()) {
+       return priorityReadyThreads->RemoveMin();
     }
     else {
        return (NachOSThread *)listOfReadyThreads->Remove();
@@ -208,6 +217,28 @@ ProcessScheduler::Print()
 {
     printf("Ready list contents:\n");
     listOfReadyThreads->Mapcar((VoidFunctionPtr) ThreadPrint);
+    priorityReadyThreads->Mapcar((VoidFunctionPtr) ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// ProcessScheduler::UsePriorityQueue
+// 	Returns TRUE if the ready threads should be kept by priority.
+//
+//	The scheduling algorithm is only chosen once the system is up
+//	(see ReadInputAndFork), so threads that became ready before that
+//	are moved over from the FIFO list, in order, the first time.
+//----------------------------------------------------------------------
+
+bool
+ProcessScheduler::UsePriorityQueue()
+{
+    NachOSThread *thread;
+
+    if ((schedulingAlgo != UNIX_SCHED) && (schedulingAlgo != NON_PREEMPTIVE_SJF))
+       return FALSE;
+    while ((thread = (NachOSThread *)listOfReadyThreads->Remove()) != NULL)
+       priorityReadyThreads->Append(thread);
+    return TRUE;
 }
 
 void
@@ -219,33 +250,31 @@ ProcessScheduler::SetEmptyReadyQueueStartTime (int ticks)
 //-------------------------------------------------------------------------
 // ProcessScheduler::UpdateThreadPriority
 //      Updates the priority of all active threads as in the UNIX scheduler
+//
+//	The currentThread is updated here.  Everybody else has its usage
+//	halved, which only advances decayEpoch: each thread catches up
+//	lazily (see NachOSThread::ApplyDecay).
 //--------------------------------------------------------------------------
 void
 ProcessScheduler::UpdateThreadPriority (void)
 {
-   unsigned i;
    int this_cpu_burst_duration = stats->totalTicks - cpu_burst_start_time;
    ASSERT(this_cpu_burst_duration > 0);
-   unsigned currentPID = currentThread->GetPID();
 
    // First we update the currentThread priority
 
    int currentThreadUsage = currentThread->GetUsage();
    currentThreadUsage = (currentThreadUsage + this_cpu_burst_duration) >> 1;
    int currentThreadPriority = currentThread->GetBasePriority() + (currentThreadUsage >> 1);
-   currentThread->SetUsage(currentThreadUsage);
-   currentThread->SetPriority(currentThreadPriority);
 
    // Update everybody else
 
-   for (i=0; i<thread_index; i++) {
-      if ((i != currentPID) && !exitThreadArray[i]) {
-         ASSERT(threadArray[i] != NULL);
-         currentThreadUsage = threadArray[i]->GetUsage();
-         currentThreadUsage = currentThreadUsage >> 1;
-         currentThreadPriority = threadArray[i]->GetBasePriority() + (currentThreadUsage >> 1);
-         threadArray[i]->SetUsage(currentThreadUsage);
-         threadArray[i]->SetPriority(currentThreadPriority);
-      }
-   }
+   decayEpoch++;
+   currentThread->SetUsage(currentThreadUsage);	// up to date with the new epoch
+   currentThread->SetPriority(currentThreadPriority);
+
+   // The ready threads are kept by priority: file again those whose
+   // priority just decayed
+
+   priorityReadyThreads->Decay();
 }
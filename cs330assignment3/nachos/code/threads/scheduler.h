@@ -12,6 +12,7 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "readyqueue.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
@@ -33,12 +34,20 @@ class ProcessScheduler {
     void SetEmptyReadyQueueStartTime (int ticks);
 
     void UpdateThreadPriority (void);	// Used by the UNIX scheduler
+    unsigned GetDecayEpoch (void) { return decayEpoch; }
+					// Number of priority updates so far
    
   private:
     List *listOfReadyThreads;  		// queue of threads that are ready to run,
 				// but not running
+    PriorityReadyQueue *priorityReadyThreads;	// the same, under UNIX_SCHED
+				// and NON_PREEMPTIVE_SJF
+
+    bool UsePriorityQueue();		// which of the two is in use?
 
     int empty_ready_queue_start_time;
+
+    unsigned decayEpoch;		// Usage decays applied to all threads
 };
 
 #endif // SCHEDULER_H
@@ -1,8 +1,7 @@
 // synch.cc 
 //	Routines for synchronizing threads.  Three kinds of
 //	synchronization routines are defined here: semaphores, locks 
-//   	and condition variables (the implementation of the last two
-//	are left to the reader).
+//   	and condition variables.
 //
 // Any implementation of a synchronization routine needs some
 // primitive atomic operation.  We assume Nachos is running on
@@ -97,16 +96,163 @@ Semaphore::V()
     (void) interrupt->SetLevel(oldLevel);
 }
 
-// Dummy functions -- so we can compile our later assignments 
-// Note -- without a correct implementation of Condition::Wait(), 
-// the test case in the network assignment won't work!
-Lock::Lock(char* debugName) {}
-Lock::~Lock() {}
-void Lock::Acquire() {}
-void Lock::Release() {}
-
-Condition::Condition(char* debugName) { }
-Condition::~Condition() { }
-void Condition::Wait(Lock* conditionLock) { ASSERT(FALSE); }
-void Condition::Signal(Lock* conditionLock) { }
-void Condition::Broadcast(Lock* conditionLock) { }
+//----------------------------------------------------------------------
+// Lock::Lock
+// 	Initialize a lock, FREE to start with.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Lock::Lock(char* debugName)
+{
+    name = debugName;
+    holder = NULL;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Lock::~Lock
+// 	De-allocate a lock, when no longer needed.  Assume no one is
+//	holding it or waiting for it!
+//----------------------------------------------------------------------
+
+Lock::~Lock()
+{
+    ASSERT(holder == NULL);
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Lock::Acquire
+// 	Wait until the lock is FREE, then take it.  As with Semaphore::P,
+//	interrupts are disabled while checking and setting the holder.
+//----------------------------------------------------------------------
+
+void
+Lock::Acquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(holder != currentThread);		// locks are not recursive
+    while (holder != NULL) {
+	queue->Append((void *)currentThread);
+	currentThread->PutThreadToSleep();
+    }
+    holder = currentThread;
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::Release
+// 	Set the lock FREE, waking up a thread waiting in Acquire() if
+//	there is one.  Only the holder may release the lock.
+//----------------------------------------------------------------------
+
+void
+Lock::Release()
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(isHeldByCurrentThread());
+    thread = (NachOSThread *)queue->Remove();
+    if (thread != NULL)
+	scheduler->MoveThreadToReadyQueue(thread);
+    holder = NULL;
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::isHeldByCurrentThread
+// 	Return TRUE if the current thread holds the lock.
+//----------------------------------------------------------------------
+
+bool
+Lock::isHeldByCurrentThread()
+{
+    return (holder == currentThread);
+}
+
+//----------------------------------------------------------------------
+// Condition::Condition
+// 	Initialize a condition variable, with no one waiting on it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Condition::Condition(char* debugName)
+{
+    name = debugName;
+    queue = new List;
+}
+
+//----------------------------------------------------------------------
+// Condition::~Condition
+// 	De-allocate a condition variable.  Assume no one is waiting on it!
+//----------------------------------------------------------------------
+
+Condition::~Condition()
+{
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Condition::Wait
+// 	Release "conditionLock" and go to sleep until signalled, then
+//	re-acquire the lock.  Releasing the lock and going to sleep are
+//	done with interrupts disabled, so that a Signal in between can't
+//	be lost.
+//----------------------------------------------------------------------
+
+void
+Condition::Wait(Lock* conditionLock)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    conditionLock->Release();
+    queue->Append((void *)currentThread);
+    currentThread->PutThreadToSleep();
+    (void) interrupt->SetLevel(oldLevel);
+
+    conditionLock->Acquire();
+}
+
+//----------------------------------------------------------------------
+// Condition::Signal
+// 	Wake up one thread waiting on the condition, if there is one.
+//	It runs once it gets the lock back (Mesa semantics), so it must
+//	check the condition again.
+//----------------------------------------------------------------------
+
+void
+Condition::Signal(Lock* conditionLock)
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    thread = (NachOSThread *)queue->Remove();
+    if (thread != NULL)
+	scheduler->MoveThreadToReadyQueue(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Condition::Broadcast
+// 	Wake up every thread waiting on the condition.
+//----------------------------------------------------------------------
+
+void
+Condition::Broadcast(Lock* conditionLock)
+{
+    NachOSThread *thread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    while ((thread = (NachOSThread *)queue->Remove()) != NULL)
+	scheduler->MoveThreadToReadyQueue(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
@@ -80,7 +80,8 @@ class Lock {
 
   private:
     char* name;				// for debugging
-    // plus some other stuff you'll need to define
+    NachOSThread *holder;		// thread holding the lock, NULL if FREE
+    List *queue;			// threads waiting in Acquire()
 };
 
 // The following class defines a "condition variable".  A condition
@@ -132,6 +133,6 @@ class Condition {
 
   private:
     char* name;
-    // plus some other stuff you'll need to define
+    List *queue;			// threads waiting in Wait()
 };
 #endif // SYNCH_H
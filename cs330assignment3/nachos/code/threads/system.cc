@@ -26,7 +26,7 @@ unsigned thread_index;			// Index into this array (also used to assign unique pi
 bool initializedConsoleSemaphores;
 bool exitThreadArray[MAX_THREAD_COUNT];  //Marks exited threads
 
-TimeSortedWaitQueue *sleepQueueHead;	// Needed to implement syscall_wrapper_Sleep
+TimerWheel *sleepQueue;			// Needed to implement syscall_wrapper_Sleep
 
 int schedulingAlgo;			// Scheduling algorithm to simulate
 char **batchProcesses;			// Names of batch processes
@@ -41,7 +41,12 @@ bool excludeMainThread;		// Used by completion time statistics calculation
 
 int pageReplacementAlgo = 0;     // default is random
 int page_pointer = 0;
-List* PageQueue = new List();
+int faultAroundMax = 4;				// set by -fa
+int faultAroundWindow = 4;			// adapted as read-ahead
+						// pages are used or wasted
+int executionEngine = INTERPRETER_ENGINE;	// set by -engine
+bool clockCheck = FALSE;			// set by -clockcheck
+bool clockReference = FALSE;			// set by -clockref
 
 //-------------------------------------------------------------------------------
 //-------------------------------------------------------------------------------
@@ -56,6 +61,12 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+SwapManager *swapManager;	// swap area for evicted pages
+PageCache *pageCache;		// pages of executables
+AdaptiveReplacement *adaptiveReplacement;	// ARC and 2Q state
+ReferenceTrace *referenceTrace;	// set by -T, else NULL
+LoadController *loadController;	// set by -lc, else NULL
+PageoutDaemon *pageoutDaemon;	// set by -pd, else NULL
 #endif
 
 #ifdef NETWORK
@@ -87,14 +98,11 @@ extern void Cleanup();
 static void
 TimerInterruptHandler(int dummy)
 {
-    TimeSortedWaitQueue *ptr;
+    NachOSThread *sleeper;
     if (interrupt->getStatus() != IdleMode) {
-        // Check the head of the sleep queue
-        while ((sleepQueueHead != NULL) && (sleepQueueHead->GetWhen() <= (unsigned)stats->totalTicks)) {
-           sleepQueueHead->GetThread()->Schedule();
-           ptr = sleepQueueHead;
-           sleepQueueHead = sleepQueueHead->GetNext();
-           delete ptr;
+        // Wake up every sleeping thread that is due
+        while ((sleeper = sleepQueue->RemoveExpired((unsigned)stats->totalTicks)) != NULL) {
+           sleeper->Schedule();
         }
         //printf("[%d] Timer interrupt.\n", stats->totalTicks);
         if ((schedulingAlgo == ROUND_ROBIN) || (schedulingAlgo == UNIX_SCHED)) {
@@ -103,7 +111,19 @@ TimerInterruptHandler(int dummy)
 	      interrupt->YieldOnReturn();
            }
         }
+#ifdef USER_PROGRAM
+        if ((loadController != NULL) && (interrupt->getStatus() == UserMode))
+           loadController->Sample();
+#endif
+    }
+#ifdef USER_PROGRAM
+    else {
+       if (loadController != NULL)
+          loadController->Idle();	// let a deactivated process run
+       if (pageoutDaemon != NULL)
+          pageoutDaemon->Idle();	// clean pages meanwhile
     }
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -143,10 +163,15 @@ Initialize(int argc, char **argv)
     for (i=0; i<MAX_THREAD_COUNT; i++) { threadArray[i] = NULL; exitThreadArray[i] = false; completionTimeArray[i] = -1; }
     thread_index = 0;
 
-    sleepQueueHead = NULL;
+    sleepQueue = new TimerWheel;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    char *traceFile = NULL;	// record page references
+    bool loadControl = FALSE;	// deactivate processes when thrashing
+    bool pageout = FALSE;	// start the page-out daemon
+    int tlbEntries = 0;		// translate through a TLB, if not 0
+    int tlbWays = 0;		// ... this associative; 0 for fully
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -175,6 +200,23 @@ Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-T")) {
+	    ASSERT(argc > 1);
+	    traceFile = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-lc"))
+	    loadControl = TRUE;
+	else if (!strcmp(*argv, "-pd"))
+	    pageout = TRUE;
+	else if (!strcmp(*argv, "-tlb")) {
+	    ASSERT(argc > 1);
+	    tlbEntries = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tlbways")) {
+	    ASSERT(argc > 1);
+	    tlbWays = atoi(*(argv + 1));
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -216,6 +258,20 @@ Initialize(int argc, char **argv)
     
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
+    if (tlbEntries > 0)
+	machine->EnableTLB(tlbEntries, (tlbWays > 0) ? tlbWays : tlbEntries);
+    swapManager = new SwapManager("SWAP");
+    pageCache = new PageCache;
+    adaptiveReplacement = new AdaptiveReplacement;
+    referenceTrace = NULL;
+    if (traceFile != NULL)
+	referenceTrace = new ReferenceTrace(traceFile);
+    loadController = NULL;
+    if (loadControl)
+	loadController = new LoadController;
+    pageoutDaemon = NULL;
+    if (pageout)
+	pageoutDaemon = new PageoutDaemon;
 #endif
 
 #ifdef FILESYS
@@ -244,6 +300,12 @@ Cleanup()
 #endif
     
 #ifdef USER_PROGRAM
+    delete pageoutDaemon;
+    delete loadController;
+    delete referenceTrace;
+    delete adaptiveReplacement;
+    delete pageCache;
+    delete swapManager;
     delete machine;
 #endif
 
@@ -255,6 +317,7 @@ Cleanup()
     delete synchDisk;
 #endif
     
+    delete sleepQueue;
     delete timer;
     delete scheduler;
     delete interrupt;
@@ -15,6 +15,7 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "timerwheel.h"
 
 #define MAX_THREAD_COUNT 1000
 #define MAX_BATCH_SIZE 100
@@ -32,6 +33,31 @@
 #define FIFO         2
 #define LRU          3
 #define LRU_CLOCK    4
+#define TWO_HANDED_CLOCK 5
+#define ARC          6
+#define TWO_Q        7
+
+#define CLOCK_HAND_SPREAD	(NumPhysPages / 2)	// frames between the
+							// two clock hands
+
+#define MAX_FAULT_AROUND	16	// Largest fault-around window, in pages
+
+#define WORKING_SET_WINDOW	1000	// Instructions over which a process's
+					// working set is estimated
+#define LOAD_CONTROL_FAULTS	10	// Faults per window above which load
+					// control considers a process thrashing
+
+#define PAGEOUT_LOW_WATER	2	// The page-out daemon starts evicting
+#define PAGEOUT_HIGH_WATER	4	// below this many free frames, and
+					// stops at this many
+#define PAGEOUT_CLEAN_BATCH	4	// Dirty pages it writes out per idle
+					// wakeup
+#define IDLE_ZERO_BATCH		4	// Free frames zeroed each time the
+					// CPU goes idle
+
+// User program execution engines
+#define INTERPRETER_ENGINE	0
+#define TRANSLATOR_ENGINE	1
 
 //-------------------------------------------------------------------------------
 //-------------------------------------------------------------------------------
@@ -78,33 +104,37 @@ extern bool excludeMainThread;		// Used by completion time statistics calculatio
 
 // for page replacement algos
 extern int pageReplacementAlgo;    // To know which page replacement algorithm is being used
-extern List* PageQueue;
 extern int page_pointer;
 
-//-------------------------------------------------------------------------------
-//-------------------------------------------------------------------------------
+extern int faultAroundMax;	// Most pages a fault reads ahead, plus one
+extern int faultAroundWindow;	// Current window, between 1 and the above
 
-class TimeSortedWaitQueue {		// Needed to implement syscall_wrapper_Sleep
-private:
-   NachOSThread *t;				// NachOSThread pointer of the sleeping thread
-   unsigned when;			// When to wake up
-   TimeSortedWaitQueue *next;		// Build the list
+extern int executionEngine;	// Interpreter or basic-block translator
+extern bool clockCheck;		// Trace interrupts and kernel entries,
+				// to compare batched and ticking clocks
+extern bool clockReference;	// Tick once per instruction, no batches
 
-public:
-   TimeSortedWaitQueue (NachOSThread *th,unsigned w) { t = th; when = w; next = NULL; }
-   ~TimeSortedWaitQueue (void) {}
-   
-   NachOSThread *GetThread (void) { return t; }
-   unsigned GetWhen (void) { return when; }
-   TimeSortedWaitQueue *GetNext(void) { return next; }
-   void SetNext (TimeSortedWaitQueue *n) { next = n; }
-};
+//-------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------
 
-extern TimeSortedWaitQueue *sleepQueueHead;
+extern TimerWheel *sleepQueue;		// Threads in syscall_wrapper_Sleep and
+					// waiting for a page to come in
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "swap.h"
+#include "pagecache.h"
+#include "replacement.h"
+#include "trace.h"
+#include "loadcontrol.h"
+#include "pageout.h"
 extern Machine* machine;	// user program memory and registers
+extern SwapManager *swapManager;	// swap area for evicted pages
+extern PageCache *pageCache;		// pages of executables
+extern AdaptiveReplacement *adaptiveReplacement;	// ARC and 2Q state
+extern ReferenceTrace *referenceTrace;	// set by -T, else NULL
+extern LoadController *loadController;	// set by -lc, else NULL
+extern PageoutDaemon *pageoutDaemon;	// set by -pd, else NULL
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
@@ -46,6 +46,7 @@ NachOSThread::NachOSThread(char* threadName, int nice)
 #ifdef USER_PROGRAM
     space = NULL;
     stateRestored = true;
+    syscallStartTicks = syscallStartSystemTicks = -1;
 #endif
 
     threadArray[thread_index] = this;
@@ -65,6 +66,9 @@ NachOSThread::NachOSThread(char* threadName, int nice)
     for (i=0; i<MAX_CHILD_COUNT; i++) exitedChild[i] = false;
 
     instructionCount = 0;
+    readyPrev = readyNext = NULL;
+    decayPrev = decayNext = NULL;
+    readyDecays = FALSE;
 
     if (nice == GET_NICE_FROM_PARENT) {
        if (ppid != -1) {
@@ -79,6 +83,48 @@ NachOSThread::NachOSThread(char* threadName, int nice)
     }
     schedPriority = basePriority;
     usage = 0;
+    decayEpoch = scheduler->GetDecayEpoch();
+
+    if (schedulingAlgo == NON_PREEMPTIVE_SJF) schedPriority = INITIAL_TAU;
+}
+
+//----------------------------------------------------------------------
+// NachOSThread::NachOSThread
+// 	Initialize a kernel thread that is not a process, such as the
+//	page-out daemon: it has no pid or parent, is not in threadArray,
+//	and so is never waited for when deciding whether every program
+//	is done.  It runs at the lowest priority.
+//----------------------------------------------------------------------
+
+NachOSThread::NachOSThread(char* threadName)
+{
+    int i;
+
+    name = new char[1024];
+    sprintf(name,"%s",threadName);
+    stackTop = NULL;
+    stack = NULL;
+    status = JUST_CREATED;
+#ifdef USER_PROGRAM
+    space = NULL;
+    stateRestored = true;
+    syscallStartTicks = syscallStartSystemTicks = -1;
+#endif
+
+    pid = ppid = -1;
+    childcount = 0;
+    waitchild_id = -1;
+    for (i=0; i<MAX_CHILD_COUNT; i++) exitedChild[i] = false;
+
+    instructionCount = 0;
+    readyPrev = readyNext = NULL;
+    decayPrev = decayNext = NULL;
+    readyDecays = FALSE;
+
+    basePriority = MAX_NICE_PRIORITY + DEFAULT_BASE_PRIORITY;
+    schedPriority = basePriority;
+    usage = 0;
+    decayEpoch = scheduler->GetDecayEpoch();
 
     if (schedulingAlgo == NON_PREEMPTIVE_SJF) schedPriority = INITIAL_TAU;
 }
@@ -271,6 +317,10 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
        }
     }
 
+#ifdef USER_PROGRAM
+    if (loadController != NULL)
+       loadController->ProcessExited(this);	// may let one back in
+#endif
     nextThread = scheduler->SelectNextReadyThread();
     if (nextThread == NULL) {
        scheduler->SetEmptyReadyQueueStartTime(stats->totalTicks);
@@ -286,16 +336,7 @@ NachOSThread::Exit (bool terminateSim, int exitcode)
        nextThread = scheduler->SelectNextReadyThread();
     }
 #ifdef USER_PROGRAM
-    TranslationEntry *T = space->GetPageTable();
-
-    for(int i = 0; i < (space->GetNumPages()); i++) {
-        if (!T[i].shared && T[i].valid) {
-            numPagesAllocated--;
-            int pn = T[i].physicalPage;
-            machine->PIDatPhysAddr[pn] = -1;
-            machine->PhysToVirtual[pn] = -1;
-        }
-    }
+    space->releasePages();
 #endif
     scheduler->ScheduleThread(nextThread); // returns when we've been signalled
 }
@@ -610,40 +651,8 @@ NachOSThread::Startup()
 void
 NachOSThread::SortedInsertInWaitQueue (unsigned when)
 {
-   TimeSortedWaitQueue *ptr, *prev, *temp;
-
-   if (sleepQueueHead == NULL) {
-      sleepQueueHead = new TimeSortedWaitQueue (this, when);
-      ASSERT(sleepQueueHead != NULL);
-   }
-   else {
-      ptr = sleepQueueHead;
-      prev = NULL;
-      while ((ptr != NULL) && (ptr->GetWhen() <= when)) {
-         prev = ptr;
-         ptr = ptr->GetNext();
-      }
-      if (ptr == NULL) {  // Insert at tail
-         ptr = new TimeSortedWaitQueue (this, when);
-         ASSERT(ptr != NULL);
-         ASSERT(prev->GetNext() == NULL);
-         prev->SetNext(ptr);
-      }
-      else if (prev == NULL) {  // Insert at head
-         ptr = new TimeSortedWaitQueue (this, when);
-         ASSERT(ptr != NULL);
-         ptr->SetNext(sleepQueueHead);
-         sleepQueueHead = ptr;
-      }
-      else {
-         temp = new TimeSortedWaitQueue (this, when);
-         ASSERT(temp != NULL);
-         temp->SetNext(ptr);
-         prev->SetNext(temp);
-      }
-   }
-
    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+   sleepQueue->Insert(this, when);
    //printf("[pid %d] Going to sleep at %d.\n", pid, stats->totalTicks);
    PutThreadToSleep();
    //printf("[pid %d] Returned from sleep at %d.\n", pid, stats->totalTicks);
@@ -661,6 +670,17 @@ NachOSThread::IncInstructionCount (void)
    instructionCount++;
 }
 
+//----------------------------------------------------------------------
+// NachOSThread::AddInstructionCount
+//      Called by Machine::Run to account for a batch of instructions
+//----------------------------------------------------------------------
+
+void
+NachOSThread::AddInstructionCount (unsigned n)
+{
+   instructionCount += n;
+}
+
 //----------------------------------------------------------------------
 // NachOSThread::GetInstructionCount
 //      Called by SysCall_NumInstr
@@ -697,10 +717,30 @@ NachOSThread::GetCPUBurstStartTime (void)
 }
 
 // Methods used by the UNIX scheduler
+//
+// Every preemption under the UNIX scheduler halves the usage of every
+// other live thread, and sets its priority to basePriority + usage/2
+// (see ProcessScheduler::UpdateThreadPriority).  Instead of visiting all
+// threads, the scheduler counts these decays in an epoch, and each
+// thread applies the decays it has missed when its usage or priority is
+// next looked at or changed.
+
+void
+NachOSThread::ApplyDecay (void)
+{
+   unsigned epoch = scheduler->GetDecayEpoch();
+   unsigned missed = epoch - decayEpoch;
+
+   if (missed == 0) return;
+   usage = (missed >= 31) ? 0 : (usage >> missed);
+   schedPriority = basePriority + (usage >> 1);
+   decayEpoch = epoch;
+}
 
 void 
 NachOSThread::SetBasePriority (int p)
 {
+   ApplyDecay();
    basePriority = p;
 }
 
@@ -713,23 +753,27 @@ NachOSThread::GetBasePriority (void)
 void 
 NachOSThread::SetPriority (int p)
 {
+   ApplyDecay();
    schedPriority = p;
 }
     
 int 
 NachOSThread::GetPriority (void)
 {
+   ApplyDecay();
    return schedPriority;
 }
 
 void 
 NachOSThread::SetUsage (int u)
 {
+   ApplyDecay();
    usage = u;
 }
     
 int 
 NachOSThread::GetUsage (void)
 {
+   ApplyDecay();
    return usage;
 }
@@ -84,6 +84,8 @@ class NachOSThread {
 
   public:
     NachOSThread(char* debugName, int nice);		// initialize a NachOSThread 
+    NachOSThread(char* debugName);		// ... that is a kernel thread,
+						// not a process
     ~NachOSThread(); 				// deallocate a NachOSThread
 					// NOTE -- thread being deleted
 					// must not be running when delete 
@@ -135,6 +137,7 @@ class NachOSThread {
     void SortedInsertInWaitQueue (unsigned when);	// Called by SysCall_Sleep handler
 
     void IncInstructionCount();
+    void AddInstructionCount(unsigned n);
     unsigned GetInstructionCount();
 
     void SetWaitStartTime (int ticks);
@@ -176,9 +179,19 @@ class NachOSThread {
 
     int basePriority, schedPriority, usage;	// Used by the UNIX scheduler
 						// schedPriority is also used to store the next burst estimate
+    unsigned decayEpoch;		// Scheduler decay epoch that usage and
+					// schedPriority are up to date with
+    void ApplyDecay (void);		// Catch up with the decays since then
 
     unsigned instructionCount;          // Keeps track of the instruction count executed by this thread
 
+    NachOSThread *readyPrev, *readyNext;	// Ready threads of the same level,
+    int readyKey;			// the priority filed under,
+    unsigned readySeq;			// and the order of arrival
+    NachOSThread *decayPrev, *decayNext;	// Ready threads whose priority
+    bool readyDecays;			// can still decay, if on that list
+    friend class PriorityReadyQueue;	// kept by the priority schedulers
+
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
 // one for its state while executing user code, one for its state 
@@ -192,6 +205,10 @@ class NachOSThread {
     void RestoreUserState();		// restore user-level register state
 
     ProcessAddressSpace *space;			// User code this thread is running.
+
+    int syscallStartTicks;		// When the system call in progress
+    int syscallStartSystemTicks;	// was made, for its statistics;
+					// -1 once it has been recorded
 #endif
 };
 
@@ -49,3 +49,52 @@ ThreadTest()
     SimpleThread(0);
 }
 
+
+//----------------------------------------------------------------------
+// BenchmarkHandler
+// 	Interrupt handler for InterruptQueueBenchmark; just counts.
+//----------------------------------------------------------------------
+
+static int benchmarkFired;
+
+static void
+BenchmarkHandler(int arg)
+{
+    benchmarkFired++;
+}
+
+//----------------------------------------------------------------------
+// InterruptQueueBenchmark
+// 	Flood the pending interrupt queue with "numEvents" timer and
+//	console events, the way many console-printing processes do, and
+//	report how long it takes the host to queue and fire them all.
+//	Invoked with "-qb <numEvents>".
+//----------------------------------------------------------------------
+
+void
+InterruptQueueBenchmark(int numEvents)
+{
+    int i, startTicks = stats->totalTicks;
+    double start, queued;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    benchmarkFired = 0;
+    start = HostTime();
+    for (i = 0; i < numEvents; i++) {
+	if (i % 2)
+	    interrupt->Schedule(BenchmarkHandler, i, 
+			TimerTicks * (1 + Random() % 16), TimerInt);
+	else
+	    interrupt->Schedule(BenchmarkHandler, i, 
+			1 + Random() % (ConsoleTime * 16), ConsoleWriteInt);
+    }
+    queued = HostTime();
+    while (benchmarkFired < numEvents) {	// each SetLevel(IntOn) is a tick
+	(void) interrupt->SetLevel(IntOn);
+	(void) interrupt->SetLevel(IntOff);
+    }
+    printf("Interrupt queue benchmark: %d events, %d ticks, "
+	   "queue %.3f s, fire %.3f s\n", numEvents,
+	   stats->totalTicks - startTicks, queued - start, HostTime() - queued);
+    (void) interrupt->SetLevel(oldLevel);
+}
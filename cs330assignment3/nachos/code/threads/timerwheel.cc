@@ -0,0 +1,250 @@
+// timerwheel.cc
+//	Routines for the hierarchical timing wheel that holds sleeping
+//	threads.  See timerwheel.h for an overview.
+//
+//	"wheelTime" is the first tick whose level 0 slot has not been
+//	expired yet.  A thread due at "when" sits on the lowest level
+//	whose span covers "when - wheelTime", in the slot picked by the
+//	matching bits of "when".  Whenever wheelTime reaches the start
+//	of a slot of a coarser level, that slot is cascaded: its threads
+//	are placed again, now on a finer level.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "timerwheel.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// TimerWheel::TimerWheel
+// 	Initialize an empty timing wheel.
+//----------------------------------------------------------------------
+
+TimerWheel::TimerWheel()
+{
+    int level, slot;
+
+    for (level = 0; level < WheelLevels; level++) {
+	for (slot = 0; slot < WheelSize; slot++)
+	    slots[level][slot] = NULL;
+	levelCount[level] = 0;
+    }
+    overflow = expired = expiredTail = NULL;
+    wheelTime = 0;
+    nextOrder = 0;
+    numEntries = numWaiting = 0;
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::~TimerWheel
+// 	De-allocate the wheel, and whatever entries are still on it.
+//----------------------------------------------------------------------
+
+TimerWheel::~TimerWheel()
+{
+    int level, slot;
+    TimerWheelEntry *entry;
+
+    for (level = 0; level < WheelLevels; level++)
+	for (slot = 0; slot < WheelSize; slot++)
+	    while ((entry = slots[level][slot]) != NULL) {
+		slots[level][slot] = entry->next;
+		delete entry;
+	    }
+    while ((entry = overflow) != NULL) {
+	overflow = entry->next;
+	delete entry;
+    }
+    while ((entry = expired) != NULL) {
+	expired = entry->next;
+	delete entry;
+    }
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::Insert
+// 	Put a thread on the wheel, to be woken up once simulated time
+//	reaches "when".  The caller puts the thread to sleep.
+//----------------------------------------------------------------------
+
+void
+TimerWheel::Insert(NachOSThread *thread, unsigned when)
+{
+    TimerWheelEntry *entry = new TimerWheelEntry(thread, when, nextOrder++);
+
+    ASSERT(entry != NULL);
+    numEntries++;
+    if (when < wheelTime) {		// already due: wake up with the batch
+	if (expiredTail == NULL)	// expired last
+	    expired = entry;
+	else
+	    expiredTail->next = entry;
+	expiredTail = entry;
+    } else {
+	Place(entry);
+	numWaiting++;
+    }
+    if (numEntries > stats->sleepQueueMaxDepth)
+	stats->sleepQueueMaxDepth = numEntries;
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::RemoveExpired
+// 	Take the next thread whose wake-up time is at or before "now"
+//	off the wheel.  Threads come out in order of wake-up time, and in
+//	order of arrival for the same wake-up time.
+//
+//	Returns NULL if no sleeping thread is due.
+//----------------------------------------------------------------------
+
+NachOSThread *
+TimerWheel::RemoveExpired(unsigned now)
+{
+    TimerWheelEntry *entry;
+    NachOSThread *thread;
+
+    Advance(now);
+    if ((entry = expired) == NULL)
+	return NULL;
+    expired = entry->next;
+    if (expired == NULL)
+	expiredTail = NULL;
+    numEntries--;
+
+    stats->sleepWakeups++;
+    stats->sleepLatenessTotal += now - entry->when;
+    if ((int) (now - entry->when) > stats->sleepLatenessMax)
+	stats->sleepLatenessMax = now - entry->when;
+
+    thread = entry->thread;
+    delete entry;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::Place
+// 	Put an entry into the slot that covers its wake-up time, on the
+//	finest level that reaches that far, or on the overflow list.
+//----------------------------------------------------------------------
+
+void
+TimerWheel::Place(TimerWheelEntry *entry)
+{
+    unsigned when = entry->when;
+    int level, slot;
+
+    ASSERT(when >= wheelTime);
+    for (level = 0; level < WheelLevels; level++) {
+	if (when - wheelTime < (1u << (WheelBits * (level + 1)))) {
+	    slot = (when >> (WheelBits * level)) & (WheelSize - 1);
+	    entry->next = slots[level][slot];
+	    slots[level][slot] = entry;
+	    levelCount[level]++;
+	    return;
+	}
+    }
+    entry->next = overflow;
+    overflow = entry;
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::Cascade
+// 	Wheel time has reached the start of the current slot of "level";
+//	place its entries again, on the finer levels.
+//----------------------------------------------------------------------
+
+void
+TimerWheel::Cascade(int level)
+{
+    int slot = (wheelTime >> (WheelBits * level)) & (WheelSize - 1);
+    TimerWheelEntry *entry, *rest = slots[level][slot];
+
+    slots[level][slot] = NULL;
+    while ((entry = rest) != NULL) {
+	rest = entry->next;
+	levelCount[level]--;
+	Place(entry);
+    }
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::Expire
+// 	Move every entry due at "wheelTime" to the end of the expired
+//	list, in order of arrival.  Entries reach a level 0 slot both
+//	directly and by cascading, so the slot itself is not in order.
+//----------------------------------------------------------------------
+
+void
+TimerWheel::Expire()
+{
+    int slot = wheelTime & (WheelSize - 1);
+    TimerWheelEntry *entry, *rest = slots[0][slot];
+    TimerWheelEntry *sorted = NULL, **ptr;
+
+    slots[0][slot] = NULL;
+    while ((entry = rest) != NULL) {
+	rest = entry->next;
+	for (ptr = &sorted; (*ptr != NULL) && ((*ptr)->order < entry->order);
+							ptr = &(*ptr)->next)
+	    ;
+	entry->next = *ptr;
+	*ptr = entry;
+	levelCount[0]--;
+	numWaiting--;
+    }
+    if (sorted == NULL)
+	return;
+    if (expiredTail == NULL)
+	expired = sorted;
+    else
+	expiredTail->next = sorted;
+    for (expiredTail = sorted; expiredTail->next != NULL;
+					expiredTail = expiredTail->next)
+	;
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::Advance
+// 	Expire every tick up to and including "now".  Runs of ticks with
+//	nothing due are skipped a level 0 revolution at a time, and all at
+//	once if the wheel is empty.
+//----------------------------------------------------------------------
+
+void
+TimerWheel::Advance(unsigned now)
+{
+    TimerWheelEntry *entry, *rest;
+    unsigned next;
+    int level;
+
+    while (wheelTime <= now) {
+	if (numWaiting == 0) {		// nothing on the wheel
+	    wheelTime = now + 1;
+	    return;
+	}
+	if ((wheelTime & (WheelSize - 1)) == 0) {
+	    for (level = 1; level < WheelLevels; level++) {
+		Cascade(level);
+		if (((wheelTime >> (WheelBits * level)) & (WheelSize - 1)) != 0)
+		    break;
+	    }
+	    if (level == WheelLevels) {	// the whole wheel came around
+		rest = overflow;
+		overflow = NULL;
+		while ((entry = rest) != NULL) {
+		    rest = entry->next;
+		    Place(entry);
+		}
+	    }
+	}
+	if (levelCount[0] == 0) {	// nothing due before the next cascade
+	    next = (wheelTime | (WheelSize - 1)) + 1;
+	    wheelTime = (next > now) ? now + 1 : next;
+	    continue;
+	}
+	Expire();
+	wheelTime++;
+    }
+}
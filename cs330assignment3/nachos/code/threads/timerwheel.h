@@ -0,0 +1,80 @@
+// timerwheel.h
+//	Data structures for the queue of sleeping threads.
+//
+//	Threads that call Sleep, and threads waiting for a page to be
+//	brought in (see ProcessAddressSpace::fixPageFault), wait here
+//	until the timer interrupt handler finds that their wake-up time
+//	has passed.
+//
+//	The queue is a hierarchical timing wheel.  Level 0 has one slot
+//	for each of the next WheelSize ticks, level 1 one slot for each
+//	of the next WheelSize runs of WheelSize ticks, and so on.  Putting
+//	a thread to sleep is O(1): the thread goes into the slot covering
+//	its wake-up time.  As time passes, each slot of a coarse level is
+//	spread over the finer level below it ("cascaded"), and the level 0
+//	slot of every tick is woken up as one batch.  Wake-up times beyond
+//	what the wheel covers wait on an overflow list.
+//
+//	Threads are woken in order of wake-up time, and threads due at
+//	the same time in the order they went to sleep, just as with the
+//	sorted list this replaces.
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class NachOSThread;
+
+#define WheelBits	6
+#define WheelSize	(1 << WheelBits)	// slots per level
+#define WheelLevels	4			// covers 2^24 ticks
+
+// One sleeping thread.
+
+class TimerWheelEntry {
+  public:
+    TimerWheelEntry(NachOSThread *th, unsigned w, unsigned o)
+	{ thread = th; when = w; order = o; next = NULL; }
+
+    NachOSThread *thread;	// the sleeping thread
+    unsigned when;		// when to wake it up
+    unsigned order;		// arrival order, to break ties
+    TimerWheelEntry *next;	// rest of the slot
+};
+
+// The queue of sleeping threads.
+
+class TimerWheel {
+  public:
+    TimerWheel();			// initialize an empty wheel
+    ~TimerWheel();			// de-allocate the wheel
+
+    void Insert(NachOSThread *thread, unsigned when);
+					// put "thread" to sleep until "when"
+    NachOSThread *RemoveExpired(unsigned now);
+					// next thread whose wake-up time is
+					// at or before "now", NULL if none
+
+    int NumSleeping() { return numEntries; }
+
+  private:
+    TimerWheelEntry *slots[WheelLevels][WheelSize];
+    int levelCount[WheelLevels];	// entries on each level
+    TimerWheelEntry *overflow;		// too far in the future
+    TimerWheelEntry *expired;		// due, waiting to be woken up,
+    TimerWheelEntry *expiredTail;	// in wake-up order
+    unsigned wheelTime;			// first tick not yet expired
+    unsigned nextOrder;			// stamp for the next Insert
+    int numEntries;			// sleeping threads, expired included
+    int numWaiting;			// entries not yet expired
+
+    void Place(TimerWheelEntry *entry);	// put entry in the slot for its time
+    void Cascade(int level);		// spread the current slot of "level"
+    void Expire();			// move the slot of "wheelTime" to
+					// the expired list
+    void Advance(unsigned now);		// expire every tick up to "now"
+};
+
+#endif // TIMERWHEEL_H
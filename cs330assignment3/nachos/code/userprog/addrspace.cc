@@ -41,6 +41,59 @@ SwapHeader (NoffHeader *noffH)
   noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
 }
 
+//----------------------------------------------------------------------
+// SegmentEnd
+// 	Return the first virtual address after segment "seg", 0 if it is
+//	empty.
+//----------------------------------------------------------------------
+
+static unsigned
+SegmentEnd(Segment *seg)
+{
+  return (seg->size > 0) ? (unsigned)(seg->virtualAddr + seg->size) : 0;
+}
+
+//----------------------------------------------------------------------
+// ReadSegment
+// 	Read the part of segment "seg" that falls in virtual addresses
+//	[from, to) out of "executable", into "into", which holds those
+//	addresses.  Bytes of "into" outside the segment are left alone.
+//----------------------------------------------------------------------
+
+static void
+ReadSegment(OpenFile *executable, Segment *seg, char *into, unsigned from, unsigned to)
+{
+  unsigned start, end;
+
+  if (seg->size <= 0) {
+    return;
+  }
+  start = max(from, (unsigned)seg->virtualAddr);
+  end = min(to, SegmentEnd(seg));
+  if (start < end) {
+    executable->ReadAt(into + (start - from), end - start,
+        seg->inFileAddr + (start - seg->virtualAddr));
+  }
+}
+
+//----------------------------------------------------------------------
+// ClearReferenced
+// 	A clock hand passes "frame": clear its reference bit.  The next
+//	reference to it has to set the bit again, so it cannot take the
+//	host translation cache.
+//----------------------------------------------------------------------
+
+static void
+ClearReferenced(int frame)
+{
+  FrameDescriptor *f = machine->frameTable->Frame(frame);
+
+  if (f->flags & FrameReferenced) {
+    f->flags &= ~FrameReferenced;
+    machine->InvalidateHostFrame(frame);
+  }
+}
+
 //----------------------------------------------------------------------
 // ProcessAddressSpace::ProcessAddressSpace
 // 	Create an address space to run a user program.
@@ -73,20 +126,28 @@ ProcessAddressSpace::ProcessAddressSpace(OpenFile *executable, char* f, int pid)
     }
   }
 
+  executableNumber = pageCache->OpenExecutable(fileName);
+  ASSERT(executableNumber != -1);
+  wsSize = wsFaults = wsLastFaults = 0;
+  wsWindowStart = -1;
+  ringAddr = 0;
+  ringEntries = 0;
+  swapReserved = 0;			// see reserveSwap
+
   executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
   if ((noffH.noffMagic != NOFFMAGIC) && 
       (WordToHost(noffH.noffMagic) == NOFFMAGIC))
     SwapHeader(&noffH);
   ASSERT(noffH.noffMagic == NOFFMAGIC);
 
-  // how big is address space?
-  size = noffH.code.size + noffH.initData.size + noffH.uninitData.size 
-    + UserStackSize;	// we need to increase the size
+  // how big is address space?  the stack goes after the last segment
+  size = max(SegmentEnd(&noffH.code), SegmentEnd(&noffH.initData));
+  size = max(size, SegmentEnd(&noffH.uninitData));
+  size += UserStackSize;	// we need to increase the size
   // to leave room for the stack
   numVirtualPages = divRoundUp(size, PageSize);
   size = numVirtualPages * PageSize;
-  backup_array = new char[size];
-  bzero(backup_array, size);
+  swapSlot = new int[numVirtualPages];
 
   // first, set up the translation 
   KernelPageTable = new TranslationEntry[numVirtualPages];
@@ -101,9 +162,11 @@ ProcessAddressSpace::ProcessAddressSpace(OpenFile *executable, char* f, int pid)
     KernelPageTable[i].readOnly = FALSE;  // if the code segment was entirely on 
     // a separate page, we could set its 
     // pages to be read-only
+    KernelPageTable[i].copyOnWrite = FALSE;
+    swapSlot[i] = -1;
   }
-  // zero out the entire address space, to zero the unitialized data segment 
-  // and the stack segment
+  // nothing is loaded yet: code and initialized data are read in on
+  // the first fault on each page, the rest is zero-filled then
   DEBUG('a', "Initializing address space, num pages %d, size %d\n", 
       numVirtualPages, size);
 }
@@ -111,6 +174,10 @@ ProcessAddressSpace::ProcessAddressSpace(OpenFile *executable, char* f, int pid)
 //----------------------------------------------------------------------
 // ProcessAddressSpace::ProcessAddressSpace (ProcessAddressSpace*) is called by a forked thread.
 //      We need to duplicate the address space of the parent.
+//
+//      Resident pages are not copied: parent and child map the same
+//      frame, read-only and marked copyOnWrite, and whichever writes to
+//      it first gets its own copy (see fixCopyOnWrite).
 //----------------------------------------------------------------------
 
 ProcessAddressSpace::ProcessAddressSpace(ProcessAddressSpace *parentSpace, int pid)
@@ -119,17 +186,11 @@ ProcessAddressSpace::ProcessAddressSpace(ProcessAddressSpace *parentSpace, int p
   numVirtualPages = parentSpace->GetNumPages();
   unsigned i, size = numVirtualPages * PageSize;
 
-  // ASSERT(numVirtualPages+numPagesAllocated <= NumPhysPages);                // check we're not trying
-  // to run anything too big --
-  // at least until we have
-  // virtual memory
-
   DEBUG('a', "Initializing address space, num pages %d, size %d\n",
       numVirtualPages, size);
   // first, set up the translation
   TranslationEntry* parentPageTable = parentSpace->GetPageTable();
-  backup_array = new char[size];
-  bzero(backup_array, size);
+  swapSlot = new int[numVirtualPages];
 
   fileName = new char[1024];
   for (int c = 0; c < 1024; c++) {
@@ -139,50 +200,45 @@ ProcessAddressSpace::ProcessAddressSpace(ProcessAddressSpace *parentSpace, int p
     }
   }
   noffH = parentSpace->noffH;
+  executableNumber = parentSpace->executableNumber;
+  wsSize = parentSpace->wsSize;		// the child starts out like its
+  wsFaults = wsLastFaults = 0;		// parent
+  wsWindowStart = -1;
+  ringAddr = 0;				// the rings' pages are shared, but
+  ringEntries = 0;			// they stay the parent's
+  swapReserved = parentSpace->swapReserved;	// by SyscallFork
 
-  int newAssigned = 0;
   KernelPageTable = new TranslationEntry[numVirtualPages];
   for (i = 0; i < numVirtualPages; i++) {
-    KernelPageTable[i].virtualPage = i;
-    KernelPageTable[i].shared = parentPageTable[i].shared;
-
-    if (parentPageTable[i].shared) {
-      KernelPageTable[i].physicalPage = parentPageTable[i].physicalPage;
-    } else {
-      if (parentPageTable[i].valid) {
-        if (numPagesAllocated == NumPhysPages)
-          KernelPageTable[i].physicalPage = getNextPhysicalPage(i, true, parentPageTable[i].physicalPage);
-        else
-          KernelPageTable[i].physicalPage = getNextPhysicalPage(i, false, parentPageTable[i].physicalPage);
-        newAssigned += 1;
-      } else {
-        KernelPageTable[i].physicalPage = -1;
+    if (parentPageTable[i].valid && !parentPageTable[i].shared) {
+      // share the frame until one of us writes to it
+      if (!parentPageTable[i].copyOnWrite) {
+        parentPageTable[i].readOnly = TRUE;
+        parentPageTable[i].copyOnWrite = TRUE;
       }
+      machine->frameTable->Frame(parentPageTable[i].physicalPage)->refCount += 1;
+      stats->cowSharedPages += 1;
     }
 
+    KernelPageTable[i].virtualPage = i;
+    KernelPageTable[i].shared = parentPageTable[i].shared;
+    KernelPageTable[i].physicalPage = parentPageTable[i].physicalPage;
     KernelPageTable[i].valid = parentPageTable[i].valid;
     KernelPageTable[i].use = parentPageTable[i].use;
     KernelPageTable[i].backup = parentPageTable[i].backup;
     KernelPageTable[i].dirty = parentPageTable[i].dirty;
-    KernelPageTable[i].readOnly = parentPageTable[i].readOnly;  	// if the code segment was entirely on
-    // a separate page, we could set its
-    // pages to be read-only
-  }
-
-  // Copy the contents
-  unsigned startAddrParent = parentPageTable[0].physicalPage*PageSize;
-  unsigned startAddrChild = (numPagesAllocated - newAssigned)*PageSize;
-  unsigned int j = 0;
-  for (j=0; j < numVirtualPages;j++) {
-    if ((parentPageTable[j].shared == FALSE) && (parentPageTable[j].valid == TRUE)) {
-      startAddrParent = parentPageTable[j].physicalPage*PageSize;
-      startAddrChild = KernelPageTable[j].physicalPage*PageSize;
-      for (i=0; i<PageSize; i++) {
-        machine->mainMemory[startAddrChild+i] = machine->mainMemory[startAddrParent+i];
-      }
+    KernelPageTable[i].readOnly = parentPageTable[i].readOnly;
+    KernelPageTable[i].copyOnWrite = parentPageTable[i].copyOnWrite;
+
+    // evicted pages share the parent's swap slot, until one of us
+    // writes a new version of the page out
+    swapSlot[i] = parentSpace->swapSlot[i];
+    if (swapSlot[i] != -1) {
+      swapManager->ShareSlot(swapSlot[i]);
     }
   }
-  memcpy(backup_array, parentSpace->backup_array, numVirtualPages * PageSize);
+  // the parent's pages are read-only now
+  machine->InvalidateTranslation(parentSpace->calling_PID, -1);
 }
 
 //----------------------------------------------------------------------
@@ -192,17 +248,8 @@ ProcessAddressSpace::ProcessAddressSpace(ProcessAddressSpace *parentSpace, int p
 
 ProcessAddressSpace::~ProcessAddressSpace()
 {
-  int i;
-  for (i = 0; i < numVirtualPages; i++) {
-    if (KernelPageTable[i].valid && !KernelPageTable[i].shared) {
-      // page is not shared but valid, remove it
-      int tmp = KernelPageTable[i].physicalPage;
-      machine->PhysToVirtual[tmp] = -1;
-      machine->PIDatPhysAddr[tmp] = -1;
-      numPagesAllocated -= 1;
-    }
-  }
-  delete[] backup_array;
+  releasePages();
+  delete[] swapSlot;
   delete KernelPageTable;
 }
 
@@ -254,13 +301,16 @@ void ProcessAddressSpace::SaveContextOnSwitch()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      Tell the machine where to find the page table, and which TLB
+//      entries are ours: they are tagged with our pid, so nothing is
+//      flushed.
 //----------------------------------------------------------------------
 
 void ProcessAddressSpace::RestoreContextOnSwitch() 
 {
   machine->KernelPageTable = KernelPageTable;
   machine->KernelPageTableSize = numVirtualPages;
+  machine->SetASID(calling_PID);
   DEBUG('t', "Size: %d\n", numVirtualPages);
 }
 
@@ -286,46 +336,59 @@ ProcessAddressSpace::addSharedMemory(unsigned int newMemory) {
   DEBUG('z', "Added %d Pages\n", numNewPages);
 
   TranslationEntry *NewKernelPageTable = new TranslationEntry[numTotalPages];
+  int *newSwapSlot = new int[numTotalPages];
 
-  for (i = 0; i < numVirtualPages; i++) {
-    NewKernelPageTable[i].virtualPage = KernelPageTable[i].virtualPage;
-    NewKernelPageTable[i].shared = KernelPageTable[i].shared;
-    NewKernelPageTable[i].physicalPage = KernelPageTable[i].physicalPage;
-    NewKernelPageTable[i].valid = KernelPageTable[i].valid;
-    NewKernelPageTable[i].backup = KernelPageTable[i].backup;
-    NewKernelPageTable[i].use = KernelPageTable[i].use;
-    NewKernelPageTable[i].dirty = KernelPageTable[i].dirty;
-    NewKernelPageTable[i].readOnly = KernelPageTable[i].readOnly;  	// if the code segment was entirely on
-    // a separate page, we could set its
-    // pages to be read-only
-  }
-
+  swapManager->AcquirePaging();
   for (i = 0; i < numNewPages; i++) {
     NewKernelPageTable[i+numVirtualPages].virtualPage = i + numVirtualPages;
     NewKernelPageTable[i+numVirtualPages].shared = TRUE;
+    stats->pageFaults += 1;
     if (numPagesAllocated == NumPhysPages)
-      NewKernelPageTable[i+numVirtualPages].physicalPage = getNextPhysicalPage(i+numVirtualPages, true, -1);
+      NewKernelPageTable[i+numVirtualPages].physicalPage = getNextPhysicalPage(i+numVirtualPages, true, -1, TRUE);
     else
-      NewKernelPageTable[i+numVirtualPages].physicalPage = getNextPhysicalPage(i+numVirtualPages, false, -1);
-
-    bzero(&(machine->mainMemory[(NewKernelPageTable[i+numVirtualPages].physicalPage) * PageSize]), PageSize);
+      NewKernelPageTable[i+numVirtualPages].physicalPage = getNextPhysicalPage(i+numVirtualPages, false, -1, TRUE);
 
     NewKernelPageTable[i+numVirtualPages].valid = TRUE;
     NewKernelPageTable[i+numVirtualPages].backup = true;
     NewKernelPageTable[i+numVirtualPages].use = FALSE;
     NewKernelPageTable[i+numVirtualPages].dirty = FALSE;
     NewKernelPageTable[i+numVirtualPages].readOnly = FALSE;  // if the code segment was entirely on 
+    NewKernelPageTable[i+numVirtualPages].copyOnWrite = FALSE;
+
+    newSwapSlot[i+numVirtualPages] = -1;
 
-    // !--IMPORTANT
-    machine->shared[NewKernelPageTable[i].physicalPage] = true;
+    // !--IMPORTANT: never replaced
+    adaptiveReplacement->Removed(NewKernelPageTable[i+numVirtualPages].physicalPage);
+    machine->frameTable->Pin(NewKernelPageTable[i+numVirtualPages].physicalPage);
+  }
+
+  // copy the old entries only now: making room for the new pages may
+  // have evicted some of them
+  for (i = 0; i < numVirtualPages; i++) {
+    NewKernelPageTable[i].virtualPage = KernelPageTable[i].virtualPage;
+    NewKernelPageTable[i].shared = KernelPageTable[i].shared;
+    NewKernelPageTable[i].physicalPage = KernelPageTable[i].physicalPage;
+    NewKernelPageTable[i].valid = KernelPageTable[i].valid;
+    NewKernelPageTable[i].backup = KernelPageTable[i].backup;
+    NewKernelPageTable[i].use = KernelPageTable[i].use;
+    NewKernelPageTable[i].dirty = KernelPageTable[i].dirty;
+    NewKernelPageTable[i].readOnly = KernelPageTable[i].readOnly;  	// if the code segment was entirely on
+    // a separate page, we could set its
+    // pages to be read-only
+    NewKernelPageTable[i].copyOnWrite = KernelPageTable[i].copyOnWrite;
+    newSwapSlot[i] = swapSlot[i];
   }
 
   KernelPageTable = NewKernelPageTable;
+  delete[] swapSlot;
+  swapSlot = newSwapSlot;
+  machine->InvalidateTranslation(calling_PID, -1);	// loaded from the old table
 
 
   unsigned int startAddr = numVirtualPages * PageSize;
   numVirtualPages += numNewPages;
   RestoreContextOnSwitch();
+  swapManager->ReleasePaging();
   return startAddr;
 
 }
@@ -334,176 +397,903 @@ ProcessAddressSpace::addSharedMemory(unsigned int newMemory) {
 //----------------------------------------------------------------------------------------------
 
 unsigned
-ProcessAddressSpace::getNextPhysicalPage(unsigned int virtualPage, bool replace, int calling_page) {
-  stats->pageFaults += 1;
-  DEBUG('w', "PageFaults: %d\n", stats->pageFaults);
+ProcessAddressSpace::getNextPhysicalPage(unsigned int virtualPage, bool replace, int calling_page,
+    bool zeroFill) {
+  FrameTable *frames = machine->frameTable;
+  FrameDescriptor *frame;
   int toBeReplaced = -1;
-  unsigned long int min_till_now = 4294967295;
-  int *cand;
-  int i;
   DEBUG('w', "callin_page: %d\n", calling_page);
+  // every frame we could take is being paged in: wait for one of the
+  // reads to finish (or for someone to exit and free frames)
+  while (replace && pageReplacementAlgo != 0 && !frames->HasVictim(calling_page)) {
+    ASSERT(frames->NumBusy() > 0);
+    swapManager->WaitForPageIn();
+    replace = (numPagesAllocated == NumPhysPages);
+  }
   if (replace && pageReplacementAlgo != 0) {
-    // Implementing Page Replacement Algorithms here
-    if (pageReplacementAlgo == RANDOM) {
-      //---------------------------------------------------------------
+    toBeReplaced = chooseVictim(calling_page, calling_PID, virtualPage);
+    evictFrame(toBeReplaced);
+  } else {
+    // there exists a fresh physical page
+    numPagesAllocated += 1;
+    toBeReplaced = frames->Allocate(zeroFill);
+    ASSERT(toBeReplaced != -1);
+    if ((pageReplacementAlgo == LRU_CLOCK) || (pageReplacementAlgo == TWO_HANDED_CLOCK)) {
+      frames->Frame(toBeReplaced)->flags |= FrameReferenced;
+    } else if (pageReplacementAlgo == LRU) {
+      frames->Touch(toBeReplaced, stats->totalTicks);
+    }
+  }
+  if ((pageReplacementAlgo == ARC) || (pageReplacementAlgo == TWO_Q)) {
+    adaptiveReplacement->Inserted(toBeReplaced, calling_PID, virtualPage);
+  }
+  frame = frames->Frame(toBeReplaced);
+  frame->owner = calling_PID;
+  frame->vpn = virtualPage;
+  frame->refCount = 1;
+  if (zeroFill) {
+    // a frame zeroed while the CPU was idle needs no clearing now
+    if (frame->flags & FrameZeroed) {
+      stats->zeroPoolHits += 1;
+    } else {
+      bzero(&(machine->mainMemory[toBeReplaced * PageSize]), PageSize);
+      stats->zeroPoolMisses += 1;
+    }
+  }
+  frame->flags &= ~FrameZeroed;
+  machine->InvalidateDecodedFrame(toBeReplaced);
+  if ((pageoutDaemon != NULL) && (NumPhysPages - numPagesAllocated < PAGEOUT_LOW_WATER)) {
+    pageoutDaemon->Wakeup();
+  }
+  return toBeReplaced;
+}
 
-      DEBUG('v', "Searching random page\n");
-      toBeReplaced = Random() % NumPhysPages;
-      // iterate forever till wanted page is found
-      while (machine->shared[toBeReplaced] || toBeReplaced == calling_page) {
-        toBeReplaced = Random() % NumPhysPages;
-      }
-      DEBUG('v', "Called by: [%d]\n", calling_page);
-      DEBUG('v', "random page found\n");
-
-      //---------------------------------------------------------------
-    } else if (pageReplacementAlgo == FIFO) {
-      //---------------------------------------------------------------
-
-      DEBUG('w', "Algo2: %d\n", pageReplacementAlgo);
-      int* tmp;
-      cand = (int*)PageQueue->Remove();
-      toBeReplaced = *cand;
-      while(toBeReplaced == calling_page || machine->shared[toBeReplaced]) {
-        DEBUG('w', "Algo2: %d\n", pageReplacementAlgo);
-        if (toBeReplaced == calling_page) {
-          tmp = cand;
-          cand = (int*)PageQueue->Remove();
-          toBeReplaced = *cand;
-        }
-        if (machine->shared[toBeReplaced]){
-          delete cand;
-          cand = (int*)PageQueue->Remove();
-          toBeReplaced = *cand;
-        }
-      }
-      if (tmp)
-        PageQueue->Append((void*)tmp);
-      PageQueue->Append((void*)cand);
-      DEBUG('v', "FIFO page found\n");
+//----------------------------------------------------------------------
+// ProcessAddressSpace::chooseVictim
+//      Pick the frame to replace with the algorithm in use, for page
+//      "vpn" of process "pid" (-1 if the page-out daemon is just making
+//      room).  "calling_page" must not be picked.
+//----------------------------------------------------------------------
 
-      //---------------------------------------------------------------
-    } else if (pageReplacementAlgo == LRU) {
-      //---------------------------------------------------------------
-
-      DEBUG('w', "Algo3: %d\n", pageReplacementAlgo);
-      // iterate through the timestamps of all pages and replace the
-      // one with leasttime stamp
-      for (i = 0; i < NumPhysPages; i++) {
-        if (i != calling_page && machine->TimeStamp[i] < min_till_now && !machine->shared[i]) {
-          toBeReplaced = i;
-          min_till_now = machine->TimeStamp[i];
-        }
-      }
-      // mark the calling page's timestamp
-      // just less than the child's timestamp so that
-      // child is MRU and parent is 2nd MRU
-      if (calling_page != -1) {
-        machine->TimeStamp[calling_page] = stats->totalTicks - 1;
-      }
-      machine->TimeStamp[toBeReplaced] = stats->totalTicks;
-      DEBUG('v', "LRU page found\n.");
-
-      //---------------------------------------------------------------
-    } else if (pageReplacementAlgo == LRU_CLOCK) {
-      //---------------------------------------------------------------
-
-      DEBUG('w', "Algo4: %d\n", pageReplacementAlgo);
-      // keep iterating until a page with reference bit reset is found
-      while (calling_page == page_pointer || machine->ReferenceBitSet[page_pointer] || 
-          machine->shared[page_pointer]) {
-        machine->ReferenceBitSet[page_pointer] = false;
-        page_pointer += 1;
-        // avoid overflow
-        page_pointer %= NumPhysPages;
+int
+ProcessAddressSpace::chooseVictim(int calling_page, int pid, unsigned vpn) {
+  FrameTable *frames = machine->frameTable;
+  int toBeReplaced = -1;
+
+  if (pageReplacementAlgo == RANDOM) {
+    //---------------------------------------------------------------
+
+    DEBUG('v', "Searching random page\n");
+    toBeReplaced = Random() % NumPhysPages;
+    // iterate forever till wanted page is found
+    while (!frames->IsReplaceable(toBeReplaced) || toBeReplaced == calling_page) {
+      toBeReplaced = Random() % NumPhysPages;
+    }
+    DEBUG('v', "Called by: [%d]\n", calling_page);
+    DEBUG('v', "random page found\n");
+
+    //---------------------------------------------------------------
+  } else if (pageReplacementAlgo == FIFO) {
+    //---------------------------------------------------------------
+
+    DEBUG('w', "Algo2: %d\n", pageReplacementAlgo);
+    // the active list is in order of allocation; the calling page
+    // is skipped, and goes to the back of the queue
+    toBeReplaced = frames->FirstActive();
+    if (toBeReplaced == calling_page) {
+      frames->MoveToTail(calling_page);
+      toBeReplaced = frames->FirstActive();
+    }
+    ASSERT(toBeReplaced != -1 && toBeReplaced != calling_page);
+    frames->MoveToTail(toBeReplaced);
+    DEBUG('v', "FIFO page found\n");
+
+    //---------------------------------------------------------------
+  } else if (pageReplacementAlgo == LRU) {
+    //---------------------------------------------------------------
+
+    DEBUG('w', "Algo3: %d\n", pageReplacementAlgo);
+    // the active list is in order of last reference, so the least
+    // recently used page is at its head
+    toBeReplaced = frames->FirstActive();
+    if (toBeReplaced == calling_page) {
+      toBeReplaced = frames->Frame(calling_page)->next;
+    }
+    ASSERT(toBeReplaced != -1);
+    // mark the calling page's timestamp
+    // just less than the child's timestamp so that
+    // child is MRU and parent is 2nd MRU
+    if (calling_page != -1) {
+      frames->Touch(calling_page, stats->totalTicks - 1);
+    }
+    frames->Touch(toBeReplaced, stats->totalTicks);
+    DEBUG('v', "LRU page found\n.");
+
+    //---------------------------------------------------------------
+  } else if (pageReplacementAlgo == LRU_CLOCK) {
+    //---------------------------------------------------------------
+
+    DEBUG('w', "Algo4: %d\n", pageReplacementAlgo);
+    // keep iterating until a page with reference bit reset is found
+    while (calling_page == page_pointer || !frames->IsReplaceable(page_pointer) ||
+        (frames->Frame(page_pointer)->flags & FrameReferenced)) {
+      ClearReferenced(page_pointer);
+      page_pointer += 1;
+      // avoid overflow
+      page_pointer %= NumPhysPages;
+    }
+    toBeReplaced = page_pointer;
+    frames->Frame(toBeReplaced)->flags |= FrameReferenced;
+    page_pointer = (page_pointer + 1) % NumPhysPages;
+    DEBUG('v', "LRU-CLOCK page found\n.");
+
+    //---------------------------------------------------------------
+  } else if (pageReplacementAlgo == TWO_HANDED_CLOCK) {
+    //---------------------------------------------------------------
+
+    DEBUG('w', "Algo5: %d\n", pageReplacementAlgo);
+    // the front hand clears reference bits; the back hand, a fixed
+    // distance behind it, takes the first frame that has not been
+    // referenced since, so a page survives only if it is used within
+    // the time the hands take to sweep the spread
+    while (TRUE) {
+      ClearReferenced((page_pointer + CLOCK_HAND_SPREAD) % NumPhysPages);
+      if ((page_pointer != calling_page) && frames->IsReplaceable(page_pointer)
+          && !(frames->Frame(page_pointer)->flags & FrameReferenced)) {
+        break;
       }
-      toBeReplaced = page_pointer;
-      machine->ReferenceBitSet[toBeReplaced] = true;
       page_pointer = (page_pointer + 1) % NumPhysPages;
-      DEBUG('v', "LRU-CLOCK page found\n.");
-
-      //---------------------------------------------------------------
     }
+    toBeReplaced = page_pointer;
+    frames->Frame(toBeReplaced)->flags |= FrameReferenced;
+    page_pointer = (page_pointer + 1) % NumPhysPages;
+    DEBUG('v', "Two-handed clock page found\n.");
+
+    //---------------------------------------------------------------
+  } else if ((pageReplacementAlgo == ARC) || (pageReplacementAlgo == TWO_Q)) {
+    //---------------------------------------------------------------
+
+    DEBUG('w', "Algo%d\n", pageReplacementAlgo);
+    toBeReplaced = adaptiveReplacement->Victim(calling_page, pid, vpn);
+    DEBUG('v', "ARC/2Q page found\n.");
 
-    // back up the previous page contents into the backup_array if changed
-    int pid = machine->PIDatPhysAddr[toBeReplaced];
-    if (pid != -1) {
-      threadArray[pid]->space->takeBackup(machine->PhysToVirtual[toBeReplaced]);
+    //---------------------------------------------------------------
+  }
+  return toBeReplaced;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::evictFrame
+//      Take the page in "frame" out of memory, writing it to swap if it
+//      has changed.  The frame stays allocated, to the caller.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::evictFrame(int toBeReplaced) {
+  FrameDescriptor *frame;
+  ProcessAddressSpace *space;
+  int slot = -1;
+  unsigned i;
+
+  // unmap the victim from every space mapping it (more than one if
+  // it is shared copy-on-write or cached), before blocking on the
+  // swap disk; if any of them changed it, write it out once, to a
+  // slot they all share
+  frame = machine->frameTable->Frame(toBeReplaced);
+  for (i = 0; i < thread_index; i++) {
+    if ((frame->refCount > 1) || (frame->flags & FrameCached)) {
+      if (exitThreadArray[i] || (threadArray[i] == NULL) || (threadArray[i]->space == NULL)
+          || !threadArray[i]->space->mapsCopyOnWrite(frame->vpn, toBeReplaced)) {
+        continue;
+      }
+    } else if ((int)i != frame->owner) {
+      continue;
     }
-  } else {
-    // there exists a fresh physical page
-    numPagesAllocated += 1;
-    for (i = 0; i < NumPhysPages; i++) {
-      if (machine->PIDatPhysAddr[i] == -1) {
-        // a page is found
-        toBeReplaced = i;
-        if (pageReplacementAlgo == LRU_CLOCK) {
-          machine->ReferenceBitSet[i] = true;
-        } else if (pageReplacementAlgo == FIFO) {
-          DEBUG('w', "replaced with: %d\n", toBeReplaced);
-          int* cand = new int;
-          *cand = toBeReplaced;
-          PageQueue->Append((void*)cand);
-        } else if (pageReplacementAlgo == LRU) {
-          machine->TimeStamp[toBeReplaced] = stats->totalTicks;
+    space = threadArray[i]->space;
+    if (space->unmapPage(frame->vpn)) {
+      if (slot == -1) {
+        // overwrite the page's old slot, unless someone else needs it
+        slot = space->swapSlot[frame->vpn];
+        if ((slot == -1) || (swapManager->SlotRefs(slot) > 1)) {
+          slot = swapManager->AllocateSlot();
+        } else {
+          swapManager->ShareSlot(slot);
         }
-        break;
       }
+      space->setSwapSlot(frame->vpn, slot);
     }
   }
-  machine->PIDatPhysAddr[toBeReplaced] = calling_PID;
-  machine->PhysToVirtual[toBeReplaced] = virtualPage;
-  return toBeReplaced;
+  if (frame->flags & FrameCached) {
+    pageCache->Remove(toBeReplaced);
+  }
+  if (frame->flags & FramePrefetched) {
+    // read ahead for nothing: narrow the fault-around window
+    frame->flags &= ~FramePrefetched;
+    stats->prefetchWasted += 1;
+    faultAroundWindow = (faultAroundWindow + 1) / 2;
+  }
+  if (slot != -1) {
+    swapManager->WritePage(slot, &(machine->mainMemory[toBeReplaced * PageSize]));
+    swapManager->FreeSlot(slot);
+  }
 }
 
-void ProcessAddressSpace::takeBackup(int vpn) {
-  unsigned tmp;
-  if (KernelPageTable[vpn].dirty) {
-    tmp = KernelPageTable[vpn].physicalPage;
-    memcpy(&(backup_array[vpn * PageSize]), &(machine->mainMemory[tmp * PageSize]), PageSize);
-    // reset the dirty bit
-    KernelPageTable[vpn].dirty = false;
+//----------------------------------------------------------------------
+// ProcessAddressSpace::cleanPage
+//      Called by the page-out daemon: if page "vpn", resident in
+//      "frame" and mapped by this space alone, has changed since it was
+//      last written to swap, write it now, so that evicting it later
+//      costs nothing.  The page stays mapped; it is marked clean before
+//      the write starts, so a store made meanwhile dirties it again.
+//
+//      Returns TRUE if the page was written.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::cleanPage(unsigned vpn, int frame) {
+  int slot;
+
+  if (!KernelPageTable[vpn].valid || ((int)KernelPageTable[vpn].physicalPage != frame)
+      || !KernelPageTable[vpn].dirty) {
+    return FALSE;
   }
+  slot = swapSlot[vpn];
+  if ((slot == -1) || (swapManager->SlotRefs(slot) > 1)) {
+    slot = swapManager->AllocateSlot();
+  } else {
+    swapManager->ShareSlot(slot);
+  }
+  setSwapSlot(vpn, slot);
+  KernelPageTable[vpn].dirty = false;
+  KernelPageTable[vpn].backup = true;
+  swapManager->WritePage(slot, &(machine->mainMemory[frame * PageSize]));
+  swapManager->FreeSlot(slot);
+  return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::unmapPage
+//      Page "vpn" is being evicted from its frame.  The page comes back
+//      private, if it was shared copy-on-write.
+//
+//      Returns TRUE if the page has changed since it was last written
+//      to swap, so that it has to be written out again.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::unmapPage(unsigned vpn) {
+  bool mustWrite = KernelPageTable[vpn].dirty;
+
+  KernelPageTable[vpn].dirty = false;
   KernelPageTable[vpn].valid = false;
   KernelPageTable[vpn].physicalPage = -1;
+  machine->InvalidateTranslation(calling_PID, vpn);
+  if (!mustWrite && (swapSlot[vpn] == -1)) {
+    // never written out: it comes back from the executable
+    KernelPageTable[vpn].backup = false;
+  }
+  if (KernelPageTable[vpn].copyOnWrite) {
+    // the page comes back private
+    KernelPageTable[vpn].readOnly = false;
+    KernelPageTable[vpn].copyOnWrite = false;
+  }
+  return mustWrite;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::setSwapSlot
+//      Page "vpn" is (being) written to swap "slot"; let go of the slot
+//      that held its previous version, if any.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::setSwapSlot(unsigned vpn, int slot) {
+  if (swapSlot[vpn] == slot) {
+    return;
+  }
+  swapManager->ShareSlot(slot);
+  if (swapSlot[vpn] != -1) {
+    swapManager->FreeSlot(swapSlot[vpn]);
+  }
+  swapSlot[vpn] = slot;
 }
 
+//----------------------------------------------------------------------
+// ProcessAddressSpace::fixPageFault
+//      Bring page "vadd" into memory: from swap if it has been loaded
+//      before, otherwise as the NOFF header says: code and initialized
+//      data pages are read from their segments of the executable, and
+//      uninitialized data and stack pages are zero-filled.
+//
+//      A page found in the page cache is a minor fault, with no I/O, and
+//      so is a zero-filled page, which is just given a zeroed frame.
+//      The others are major faults: reading from swap blocks for as
+//      long as the disk takes, without holding the paging lock; reading
+//      the executable is charged a fixed delay.
+//
+//      Code and data pages are read with fault-around: the pages after
+//      the faulting one in the same segment, up to the current window,
+//      are read in the same request (or mapped, if they are cached).
+//----------------------------------------------------------------------
 
 void
 ProcessAddressSpace::fixPageFault(unsigned int vadd) {
   unsigned vpn = vadd / PageSize;
   unsigned newPhysicalPage;
+  bool fromSwap = KernelPageTable[vpn].backup;
+  int faultTime = stats->totalTicks;
+  int offset = vpn * PageSize;		// names the page in the page cache
+  SegmentType segment = segmentOf(vpn);
+  bool cacheable = !fromSwap
+      && ((segment == CodeSegment) || (segment == InitDataSegment));
+  bool zeroFill = !fromSwap && !cacheable;	// uninitialized data or stack
+  int cachedFrame, run, i;
+  int batchFrame[MAX_FAULT_AROUND];
+  char *batch;
   DEBUG('v', "---------------fixing-------\n");
+  wsFaults++;
+  switch (segment) {
+    case CodeSegment: stats->codeFaults += 1; break;
+    case InitDataSegment: stats->initDataFaults += 1; break;
+    case UninitDataSegment: stats->uninitDataFaults += 1; break;
+    case StackSegment: stats->stackFaults += 1; break;
+  }
+  swapManager->AcquirePaging();
+  stats->pageFaults += 1;
+  run = cacheable ? faultAroundRun(vpn) : 1;
+  if (cacheable && ((cachedFrame = pageCache->Lookup(executableNumber, offset)) != -1)) {
+    // another process running this program has the page: share it,
+    // and the cached pages after it
+    mapCachedRun(vpn, cachedFrame, run);
+    swapManager->ReleasePaging();
+    return;
+  }
   if (numPagesAllocated == NumPhysPages) {
-    newPhysicalPage = getNextPhysicalPage(vpn, true, -1);
+    newPhysicalPage = getNextPhysicalPage(vpn, true, -1, zeroFill);
   } else {
-    newPhysicalPage = getNextPhysicalPage(vpn, false, -1);
+    newPhysicalPage = getNextPhysicalPage(vpn, false, -1, zeroFill);
+  }
+  if (cacheable && ((cachedFrame = pageCache->Lookup(executableNumber, offset)) != -1)) {
+    // getNextPhysicalPage may have waited for a frame without the
+    // paging lock, and another process cached the page meanwhile
+    freeFrame(newPhysicalPage);
+    mapCachedRun(vpn, cachedFrame, run);
+    swapManager->ReleasePaging();
+    return;
+  }
+  if (cacheable) {
+    stats->pageCacheMisses += 1;
   }
   DEBUG('v', "---------------fixed-------\n");
   DEBUG('s', "[VPN: %d], [Allocated: %d]\n", vpn, newPhysicalPage);
-  bzero(&(machine->mainMemory[newPhysicalPage * PageSize]), PageSize);
-  OpenFile *executable = fileSystem->Open(fileName);
 
-  KernelPageTable[vpn].physicalPage = newPhysicalPage;
-  KernelPageTable[vpn].valid = true;
+  if (fromSwap) {
+    // read the page back from its swap slot, letting other threads
+    // fault while the disk works
+    ASSERT(swapSlot[vpn] != -1);
+    machine->frameTable->BeginIO(newPhysicalPage);
+    swapManager->ReleasePaging();
+    swapManager->ReadPage(swapSlot[vpn], &(machine->mainMemory[newPhysicalPage * PageSize]));
+    swapManager->AcquirePaging();
+    machine->frameTable->EndIO(newPhysicalPage);
+    swapManager->PageInDone();
+    KernelPageTable[vpn].physicalPage = newPhysicalPage;
+    KernelPageTable[vpn].valid = true;
+  } else if (cacheable) {
+    // take frames for the pages read ahead, as long as that does not
+    // mean waiting; the frames taken so far are kept out of reach
+    batchFrame[0] = newPhysicalPage;
+    machine->frameTable->BeginIO(newPhysicalPage);
+    for (i = 1; i < run; i++) {
+      if ((pageCache->Lookup(executableNumber, offset + i * PageSize) != -1)
+          || ((numPagesAllocated == NumPhysPages) && !machine->frameTable->HasVictim(-1))) {
+        break;
+      }
+      batchFrame[i] = getNextPhysicalPage(vpn + i, numPagesAllocated == NumPhysPages, -1);
+      machine->frameTable->BeginIO(batchFrame[i]);
+    }
+    run = i;
+
+    // read them all at once; the page cache keeps them, clean, and we
+    // map them copy-on-write
+    batch = new char[run * PageSize];
+    readPages(batch, vpn, run);
+    for (i = run - 1; i >= 0; i--) {
+      memcpy(&(machine->mainMemory[batchFrame[i] * PageSize]), &(batch[i * PageSize]), PageSize);
+      pageCache->Insert(executableNumber, offset + i * PageSize, batchFrame[i]);
+      machine->frameTable->Frame(batchFrame[i])->owner = -1;
+      mapCachedPage(vpn + i, batchFrame[i]);
+      machine->frameTable->EndIO(batchFrame[i]);
+      if (i > 0) {
+        machine->frameTable->Frame(batchFrame[i])->flags |= FramePrefetched;
+      }
+    }
+    delete [] batch;
+    stats->prefetchedPages += run - 1;
+    swapManager->PageInDone();
+  } else {
+    // zero-fill: getNextPhysicalPage cleared the frame, or took one
+    // cleared ahead of time; it stays clean until written, and comes
+    // back zero-filled if evicted before then
+    KernelPageTable[vpn].physicalPage = newPhysicalPage;
+    KernelPageTable[vpn].valid = true;
+    KernelPageTable[vpn].dirty = false;
+    KernelPageTable[vpn].backup = true;
+    swapManager->ReleasePaging();
+    stats->minorFaults += 1;
+    return;
+  }
+
+  KernelPageTable[vpn].backup = true;
+  swapManager->ReleasePaging();
+  if (!fromSwap) {
+    // the executable is not on the simulated disk: charge a fixed delay
+    DEBUG('v', "---------------Going to sleep-------\n");
+    currentThread->SortedInsertInWaitQueue(1000+stats->totalTicks);
+    DEBUG('v', "---------------Returned from sleep[pid: %d]-------\n\n", calling_PID);
+  }
+  stats->majorFaults += 1;
+  stats->majorFaultTicks += stats->totalTicks - faultTime;
+  return;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::segmentOf
+//      Return the segment page "vpn" belongs to.  A page holding the
+//      end of one segment and the start of the next belongs to the
+//      first, so any page with code or initialized data in it is read
+//      from the executable.
+//----------------------------------------------------------------------
+
+SegmentType
+ProcessAddressSpace::segmentOf(unsigned vpn) {
+  unsigned addr = vpn * PageSize;
+
+  if (addr < SegmentEnd(&noffH.code)) {
+    return CodeSegment;
+  } else if (addr < SegmentEnd(&noffH.initData)) {
+    return InitDataSegment;
+  } else if (addr < SegmentEnd(&noffH.uninitData)) {
+    return UninitDataSegment;
+  }
+  return StackSegment;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::readPages
+//      Fill "into" with the "n" pages starting at "vpn", as the program
+//      starts out: the bytes of code and initialized data from where
+//      each segment is in the executable, zero everywhere else.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::readPages(char *into, unsigned vpn, int n) {
+  OpenFile *executable = pageCache->Executable(executableNumber);
+  unsigned from = vpn * PageSize, to = (vpn + n) * PageSize;
 
+  bzero(into, n * PageSize);
+  ReadSegment(executable, &noffH.code, into, from, to);
+  ReadSegment(executable, &noffH.initData, into, from, to);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::faultAroundRun
+//      How many pages, starting at "vpn", to bring in on a fault on
+//      "vpn": the current fault-around window, cut short at the end of
+//      the segment holding "vpn" (code or initialized data), and at the
+//      first page that is resident or has been loaded before.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::faultAroundRun(unsigned vpn) {
+  unsigned end;
+  int n;
 
-  if (KernelPageTable[vpn].backup) {
-    // copy page from backup array to the main memory
-    memcpy(&(machine->mainMemory[PageSize * newPhysicalPage]), &(backup_array[PageSize * vpn]), PageSize);
+  if (pageReplacementAlgo == 0) {
+    return 1;		// nothing read ahead in vain could be reclaimed
+  }
+  if (segmentOf(vpn) == CodeSegment) {
+    end = SegmentEnd(&noffH.code);
   } else {
-    // read directly from executable
-    KernelPageTable[vpn].dirty = true;
-    executable->ReadAt(&(machine->mainMemory[newPhysicalPage * PageSize]),
-        PageSize, noffH.code.inFileAddr + vpn*PageSize);
+    end = SegmentEnd(&noffH.initData);
   }
+  for (n = 1; n < faultAroundWindow; n++) {
+    if ((vpn + n >= numVirtualPages) || ((vpn + n) * PageSize >= end)
+        || KernelPageTable[vpn + n].valid || KernelPageTable[vpn + n].backup
+        || KernelPageTable[vpn + n].shared) {
+      break;
+    }
+  }
+  return n;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::mapCachedRun
+//      Page "vpn" is in the page cache, in "frame": map it, and the pages
+//      after it that are cached too, up to "run" pages in all.  A minor
+//      fault.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::mapCachedRun(unsigned vpn, int frame, int run) {
+  int offset = vpn * PageSize;
+  int i;
+
+  stats->minorFaults += 1;
+  stats->pageCacheHits += 1;
+  for (i = 0; (i < run) && (frame != -1); i++) {
+    machine->frameTable->Frame(frame)->refCount += 1;
+    mapCachedPage(vpn + i, frame);
+    DEBUG('s', "[VPN: %d], [Cached: %d]\n", vpn + i, frame);
+    frame = pageCache->Lookup(executableNumber, offset + (i + 1) * PageSize);
+  }
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::mapCachedPage
+//      Map page "vpn" to "frame" of the page cache: clean, and
+//      copy-on-write, so that writing to it makes a private copy.
+//----------------------------------------------------------------------
 
+void
+ProcessAddressSpace::mapCachedPage(unsigned vpn, int frame) {
+  KernelPageTable[vpn].physicalPage = frame;
+  KernelPageTable[vpn].valid = true;
+  KernelPageTable[vpn].use = false;
+  KernelPageTable[vpn].dirty = false;
+  KernelPageTable[vpn].readOnly = true;
+  KernelPageTable[vpn].copyOnWrite = true;
   KernelPageTable[vpn].backup = true;
-  delete executable;
-  DEBUG('v', "---------------Going to sleep-------\n");
-  currentThread->SortedInsertInWaitQueue(1000+stats->totalTicks);
-  DEBUG('v', "---------------Returned from sleep[pid: %d]-------\n\n", calling_PID);
-  return;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::mapsCopyOnWrite
+//      Returns TRUE if page "vpn" of this space is resident in "frame"
+//      and shared copy-on-write.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::mapsCopyOnWrite(unsigned vpn, int frame) {
+  return ((vpn < numVirtualPages) && KernelPageTable[vpn].valid
+      && KernelPageTable[vpn].copyOnWrite
+      && (KernelPageTable[vpn].physicalPage == frame));
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::isSharedFrame
+//      Returns TRUE if someone besides this space holds on to "frame":
+//      another space mapping it copy-on-write, or the page cache.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::isSharedFrame(int frame) {
+  FrameDescriptor *f = machine->frameTable->Frame(frame);
+
+  return ((f->refCount > 1) || (f->flags & FrameCached));
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::dropSharedFrame
+//      This space stops mapping a frame that other spaces still map
+//      copy-on-write, or that the page cache keeps.  If the frame was
+//      recorded as ours, hand it over to one of the other spaces, so
+//      that evicting it later backs up a live space.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::dropSharedFrame(int frame) {
+  unsigned i;
+  FrameDescriptor *f = machine->frameTable->Frame(frame);
+
+  ASSERT(isSharedFrame(frame));
+  f->refCount -= 1;
+  if (f->owner != calling_PID) {
+    return;
+  }
+  for (i = 0; i < thread_index; i++) {
+    if (!exitThreadArray[i] && (threadArray[i] != NULL) && (threadArray[i]->space != NULL)
+        && (threadArray[i]->space != this)
+        && threadArray[i]->space->mapsCopyOnWrite(f->vpn, frame)) {
+      f->owner = i;
+      return;
+    }
+  }
+  ASSERT(FALSE);	// the reference count is wrong
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::fixCopyOnWrite
+//      Called on a ReadOnlyException.  If the page is shared
+//      copy-on-write, give this space a private, writable copy (or
+//      simply make it writable, if no one else maps it any more).
+//
+//      Returns FALSE if the page really is read-only.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::fixCopyOnWrite(unsigned int vadd) {
+  unsigned vpn = vadd / PageSize;
+  int oldFrame, newFrame;
+
+  if ((vpn >= numVirtualPages) || !KernelPageTable[vpn].copyOnWrite) {
+    return FALSE;
+  }
+  ASSERT(KernelPageTable[vpn].valid);
+  swapManager->AcquirePaging();
+  oldFrame = KernelPageTable[vpn].physicalPage;
+  if (isSharedFrame(oldFrame)) {
+    // the old frame is passed as calling_page, so it is not evicted
+    // while the lock is held; but getNextPhysicalPage may wait for a
+    // frame without it, and someone else may evict the old frame then
+    stats->pageFaults += 1;
+    newFrame = getNextPhysicalPage(vpn, numPagesAllocated == NumPhysPages, oldFrame);
+    if (!KernelPageTable[vpn].valid || ((int)KernelPageTable[vpn].physicalPage != oldFrame)
+        || !KernelPageTable[vpn].copyOnWrite) {
+      // it was: the page is no longer mapped, so let the instruction
+      // fault it back in
+      freeFrame(newFrame);
+      swapManager->ReleasePaging();
+      return TRUE;
+    }
+    memcpy(&(machine->mainMemory[newFrame * PageSize]),
+        &(machine->mainMemory[oldFrame * PageSize]), PageSize);
+    if (isSharedFrame(oldFrame)) {
+      dropSharedFrame(oldFrame);
+    } else {
+      // the others exited while we waited for the swap disk
+      freeFrame(oldFrame);
+    }
+    KernelPageTable[vpn].physicalPage = newFrame;
+    stats->cowCopies += 1;
+    DEBUG('s', "[VPN: %d], copied on write from %d to %d\n", vpn, oldFrame, newFrame);
+  }
+  KernelPageTable[vpn].readOnly = FALSE;
+  KernelPageTable[vpn].copyOnWrite = FALSE;
+  machine->InvalidateTranslation(calling_PID, vpn);
+  swapManager->ReleasePaging();
+  return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::refillTLB
+//      Called on a PageFaultException when translating through the
+//      TLB: if page "vadd" is resident, only the TLB missed it, so load
+//      its translation.
+//
+//      Returns FALSE if the page is not resident, and so is a real
+//      page fault.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::refillTLB(unsigned int vadd) {
+  unsigned vpn = vadd / PageSize;
+
+  ASSERT(vpn < numVirtualPages);
+  if (!KernelPageTable[vpn].valid) {
+    return FALSE;
+  }
+  machine->LoadTLB(vpn, &KernelPageTable[vpn]);
+  return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::userPage
+//      Return where page "vpn" is in mainMemory, so the kernel can copy
+//      to or from it: fault it in first if need be, and if "writing",
+//      give us a private copy of a copy-on-write page.  The reference
+//      is recorded as if the program had made it.
+//
+//      Returns NULL if "vpn" is not in the address space, or "writing"
+//      to a page that really is read-only.
+//----------------------------------------------------------------------
+
+char *
+ProcessAddressSpace::userPage(unsigned vpn, bool writing) {
+  TranslationEntry *entry;
+
+  if (vpn >= numVirtualPages) {
+    return NULL;
+  }
+  entry = &KernelPageTable[vpn];
+  // fixing a fault may block, and the page be evicted meanwhile
+  while (!entry->valid || (writing && entry->readOnly)) {
+    if (!entry->valid) {
+      fixPageFault(vpn * PageSize);
+    } else if (!fixCopyOnWrite(vpn * PageSize)) {
+      return NULL;
+    }
+  }
+  machine->NoteAccess(entry, entry->physicalPage, writing);
+  if (writing) {
+    machine->InvalidateDecodedFrame(entry->physicalPage);
+  }
+  return &(machine->mainMemory[entry->physicalPage * PageSize]);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::CopyFromUser
+//      Copy "size" bytes at virtual address "vaddr" into the kernel
+//      buffer "into": one translation, and one memcpy, per page.
+//
+//      Returns FALSE if some of the bytes are not in the address space.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::CopyFromUser(char *into, unsigned vaddr, int size) {
+  int done, n, offset;
+  char *page;
+
+  for (done = 0; done < size; done += n) {
+    if ((page = userPage((vaddr + done) / PageSize, FALSE)) == NULL) {
+      return FALSE;
+    }
+    offset = (vaddr + done) % PageSize;
+    n = min(size - done, PageSize - offset);
+    memcpy(into + done, page + offset, n);
+  }
+  return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::CopyToUser
+//      Copy "size" bytes of the kernel buffer "from" to virtual address
+//      "vaddr", a page at a time, like CopyFromUser.
+//
+//      Returns FALSE if some of the bytes are not in the address space,
+//      or are read-only.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::CopyToUser(unsigned vaddr, char *from, int size) {
+  int done, n, offset;
+  char *page;
+
+  for (done = 0; done < size; done += n) {
+    if ((page = userPage((vaddr + done) / PageSize, TRUE)) == NULL) {
+      return FALSE;
+    }
+    offset = (vaddr + done) % PageSize;
+    n = min(size - done, PageSize - offset);
+    memcpy(page + offset, from + done, n);
+  }
+  return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::CopyStringFromUser
+//      Copy the string at virtual address "vaddr" into the kernel
+//      buffer "into", of "size" bytes, a page at a time: at most
+//      size - 1 characters, and a '\0' after them.
+//
+//      Returns the number of characters copied, size - 1 if the string
+//      may be longer (the rest starts at vaddr + size - 1), or -1 if it
+//      runs out of the address space.
+//----------------------------------------------------------------------
+
+int
+ProcessAddressSpace::CopyStringFromUser(char *into, unsigned vaddr, int size) {
+  int done = 0, n, offset;
+  char *page, *end = NULL;
+
+  ASSERT(size > 0);
+  while ((done < size - 1) && (end == NULL)) {
+    if ((page = userPage((vaddr + done) / PageSize, FALSE)) == NULL) {
+      return -1;
+    }
+    offset = (vaddr + done) % PageSize;
+    n = min(size - 1 - done, PageSize - offset);
+    end = (char *) memchr(page + offset, '\0', n);
+    if (end != NULL) {
+      n = end - (page + offset);
+    }
+    memcpy(into + done, page + offset, n);
+    done += n;
+  }
+  into[done] = '\0';
+  return done;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::sampleWorkingSet
+//      Called by load control at timer interrupts, with "now" the
+//      number of instructions the process has executed.  Once every
+//      WORKING_SET_WINDOW instructions, take the resident pages whose
+//      use bit was set since the last time as the working set, clear
+//      the use bits, and keep the number of faults taken meanwhile.
+//
+// Returns:
+//      TRUE if a new estimate was made.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::sampleWorkingSet(unsigned now) {
+  unsigned i;
+  int referenced = 0;
+
+  if (wsWindowStart == -1) {	// first time: start the window
+    wsWindowStart = now;
+    return FALSE;
+  }
+  if (now - (unsigned) wsWindowStart < WORKING_SET_WINDOW) {
+    return FALSE;
+  }
+  for (i = 0; i < numVirtualPages; i++) {
+    if (KernelPageTable[i].valid && KernelPageTable[i].use) {
+      referenced++;
+      KernelPageTable[i].use = FALSE;
+    }
+  }
+  wsSize = referenced;
+  wsLastFaults = wsFaults;
+  wsFaults = 0;
+  wsWindowStart = now;
+  return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::freeFrame
+//      Put a frame no one maps any more back on the free list.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::freeFrame(int frame) {
+  adaptiveReplacement->Removed(frame);
+  machine->frameTable->Free(frame);
+  numPagesAllocated -= 1;
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::releasePages
+//      Give up every frame and swap slot of this space, on exit or
+//      exec.  Frames and slots that are still shared stay with the
+//      other spaces.
+//----------------------------------------------------------------------
+
+void
+ProcessAddressSpace::releasePages() {
+  unsigned i;
+  int frame;
+
+  for (i = 0; i < numVirtualPages; i++) {
+    if (KernelPageTable[i].valid && !KernelPageTable[i].shared) {
+      frame = KernelPageTable[i].physicalPage;
+      if (KernelPageTable[i].copyOnWrite && isSharedFrame(frame)) {
+        dropSharedFrame(frame);
+      } else {
+        // page is not shared but valid, remove it
+        freeFrame(frame);
+      }
+      KernelPageTable[i].valid = FALSE;
+      KernelPageTable[i].physicalPage = -1;
+      KernelPageTable[i].copyOnWrite = FALSE;
+    }
+    if (swapSlot[i] != -1) {
+      swapManager->FreeSlot(swapSlot[i]);
+      swapSlot[i] = -1;
+    }
+  }
+  swapManager->Unreserve(swapReserved);
+  swapReserved = 0;
+  machine->InvalidateTranslation(calling_PID, -1);
+}
+
+//----------------------------------------------------------------------
+// ProcessAddressSpace::reserveSwap
+//      Reserve a swap slot for each page of a new program, so that
+//      evicting them can never run out of swap.  Pages added later by
+//      addSharedMemory are pinned and need none.
+//
+//      Returns FALSE if there is not enough swap left for the program.
+//----------------------------------------------------------------------
+
+bool
+ProcessAddressSpace::reserveSwap() {
+  ASSERT(swapReserved == 0);
+  if (!swapManager->Reserve(numVirtualPages)) {
+    return FALSE;
+  }
+  swapReserved = numVirtualPages;
+  return TRUE;
 }
 //----------------------------------------------------------------------------------------------
 //----------------------------------------------------------------------------------------------
@@ -19,6 +19,10 @@
 
 #define UserStackSize		1024 	// increase this as necessary!
 
+// The segment of the program a page belongs to.  Code and initialized
+// data pages are read from the executable; the others start out zero.
+enum SegmentType { CodeSegment, InitDataSegment, UninitDataSegment, StackSegment };
+
 class ProcessAddressSpace {
   public:
     ProcessAddressSpace(OpenFile *executable, char* f, int pid);	// Create an address space,
@@ -41,21 +45,66 @@ class ProcessAddressSpace {
     TranslationEntry* GetPageTable();
 
     unsigned int addSharedMemory(unsigned int);
+
+    bool CopyFromUser(char *into, unsigned vaddr, int size);
+    bool CopyToUser(unsigned vaddr, char *from, int size);
+    int CopyStringFromUser(char *into, unsigned vaddr, int size);
+					// Copy between the kernel and this
+					// address space, a page at a time
     
-    void takeBackup(int);
-    unsigned int getNextPhysicalPage(unsigned int, bool, int);
+    bool unmapPage(unsigned vpn);		// evicted; TRUE if it must be
+						// written to swap
+    void setSwapSlot(unsigned vpn, int slot);	// where it was written
+    unsigned int getNextPhysicalPage(unsigned int, bool, int, bool zeroFill = FALSE);
+    static int chooseVictim(int calling_page, int pid, unsigned vpn);
+    static void evictFrame(int frame);		// unmap it, write it if dirty
+    static void freeFrame(int frame);		// back on the free list
+    bool cleanPage(unsigned vpn, int frame);	// write it, keep it mapped
 
     void fixPageFault(unsigned int vadd);
+    bool refillTLB(unsigned int vadd);		// TLB miss on a resident page
+    bool fixCopyOnWrite(unsigned int vadd);	// first write to a page
+						// shared by fork
+    bool mapsCopyOnWrite(unsigned vpn, int frame);
+    void releasePages();			// on exit or exec
+    bool reserveSwap();				// for its pages; FALSE if
+						// there is not enough left
+    int reservedSwap() { return swapReserved; }
+
+    bool sampleWorkingSet(unsigned now);	// for load control
+    int workingSetSize() { return wsSize; }
+    int faultRate() { return wsLastFaults; }	// faults in the last window
 
     NoffHeader noffH;
     char* fileName;
-    char* backup_array;
+    int executableNumber;		// in the page cache
+    int* swapSlot;			// slot holding each evicted page,
+					// -1 if none
+    unsigned ringAddr;			// RingHeader of the syscall rings,
+    int ringEntries;			// and their size; 0 if none
 
   private:
+    char *userPage(unsigned vpn, bool writing);	// where it is in memory
+    SegmentType segmentOf(unsigned vpn);
+    void readPages(char *into, unsigned vpn, int n);	// from the executable
+    int faultAroundRun(unsigned vpn);
+    void mapCachedRun(unsigned vpn, int frame, int run);
+    void mapCachedPage(unsigned vpn, int frame);
+    bool isSharedFrame(int frame);
+    void dropSharedFrame(int frame);
+
     TranslationEntry *KernelPageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numVirtualPages;		// Number of pages in the virtual 
 					// address space
+    int swapReserved;			// swap slots reserved for the pages
+					// that can be evicted
+
+    int wsSize;				// pages referenced in the last window
+    int wsFaults;			// faults in the current window
+    int wsLastFaults;			// ... and in the last one
+    int wsWindowStart;			// instruction count it started at,
+					// -1 before the first sample
 };
 
 #endif // ADDRSPACE_H
@@ -21,34 +21,14 @@
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
 
+#include <stddef.h>		// for offsetof
+
 #include "copyright.h"
 #include "system.h"
 #include "syscall.h"
 #include "console.h"
 #include "synch.h"
 
-//----------------------------------------------------------------------
-// ExceptionHandler
-// 	Entry point into the Nachos kernel.  Called when a user program
-//	is executing, and either does a syscall, or generates an addressing
-//	or arithmetic exception.
-//
-// 	For system calls, the following is the calling convention:
-//
-// 	system call code -- r2
-//		arg1 -- r4
-//		arg2 -- r5
-//		arg3 -- r6
-//		arg4 -- r7
-//
-//	The result of the system call, if any, must be put back into r2. 
-//
-// And don't forget to increment the pc before returning. (Or else you'll
-// loop making the same system call forever!
-//
-//	"which" is the kind of exception.  The list of possible exceptions 
-//	are in machine.h.
-//----------------------------------------------------------------------
 static Semaphore *readAvail;
 static Semaphore *writeDone;
 static void ReadAvail(int arg) { readAvail->V(); }
@@ -79,242 +59,605 @@ static void ConvertIntToHex (unsigned v, Console *console)
    }
 }
 
+//----------------------------------------------------------------------
+// System calls
+// 	Each system call is handled by one routine, found in syscallTable
+//	by its number (see syscall.h).  Arguments are in r4..r7, and the
+//	result, if any, goes in r2.
+//
+//	A handler returns TRUE if the PC must be advanced past the
+//	syscall instruction once it is done, which ExceptionHandler does
+//	for all of them; the ones that never return to the caller, or
+//	advance the PC themselves, return FALSE.
+//
+//	The call count and the ticks each call takes (including any time
+//	it sleeps) are kept per system call, and printed at halt by
+//	PrintSyscallStatistics.
+//
+//	The system calls marked batchable can also be queued on the
+//	submission ring of RingSetup, and run by RingEnter without a
+//	trap each (see syscall.h).
+//----------------------------------------------------------------------
+
+#define NumSyscalls		(SysCall_NumInstr + 1)
+#define NumTickBuckets		16	// 0, 1, 2-3, 4-7, ..., and the rest
+
+typedef bool (*SyscallHandler)(void);
+
+static char *syscallName[NumSyscalls];
+static SyscallHandler syscallTable[NumSyscalls];
+static bool syscallBatchable[NumSyscalls];	// may be queued on the ring
+static int syscallCount[NumSyscalls];
+static int syscallTicks[NumSyscalls];		// summed, blocked or not
+static int syscallSystemTicks[NumSyscalls];	// ... and in the kernel
+static int syscallHistogram[NumSyscalls][NumTickBuckets];
+
+static Console *userConsole;		// the console the Print calls write to
+
+static void RecordSyscall(int type);
+
+//----------------------------------------------------------------------
+// AdvancePC
+// 	Step past the syscall instruction, so that the user program does
+//	not make the same system call forever.
+//----------------------------------------------------------------------
+
+static void
+AdvancePC()
+{
+   machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
+   machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
+   machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
+}
+
+static bool
+SyscallHalt()
+{
+   DEBUG('a', "Shutdown, initiated by user program.\n");
+   RecordSyscall(SysCall_Halt);		// Halt does not return
+   interrupt->Halt();
+   return FALSE;
+}
+
+static bool
+SyscallExit()
+{
+   int exitcode = machine->ReadRegister(4);
+   unsigned i;
+
+   printf("[pid %d]: Exit called. Code: %d\n", currentThread->GetPID(), exitcode);
+   // We do not wait for the children to finish.
+   // The children will continue to run.
+   // We will worry about this when and if we implement signals.
+   exitThreadArray[currentThread->GetPID()] = true;
+
+   // Find out if all threads have called exit
+   for (i=0; i<thread_index; i++) {
+      if (!exitThreadArray[i]) break;
+   }
+   RecordSyscall(SysCall_Exit);		// Exit does not return
+   currentThread->Exit(i==thread_index, exitcode);
+   return FALSE;
+}
+
+static bool
+SyscallExec()
+{
+   char buffer[1024];
+   int length;
+
+   // Copy the executable name into kernel space
+   length = currentThread->space->CopyStringFromUser(buffer, machine->ReadRegister(4),
+                                                     sizeof(buffer));
+   if ((length == -1) || (length == (int)sizeof(buffer) - 1)) {
+      printf("[pid %d] Exec: bad executable name.\n", currentThread->GetPID());
+      machine->WriteRegister(2, -1);
+      return TRUE;
+   }
+   RecordSyscall(SysCall_Exec);		// nor does a successful Exec
+   LaunchUserProcess(buffer);
+   machine->WriteRegister(2, -1);	// the program could not be run
+   return TRUE;
+}
+
+static bool
+SyscallJoin()
+{
+   int waitpid = machine->ReadRegister(4);
+   int whichChild;
+
+   // Check if this is my child. If not, return -1.
+   whichChild = currentThread->CheckIfChild (waitpid);
+   if (whichChild == -1) {
+      printf("[pid %d] Cannot join with non-existent child [pid %d].\n", currentThread->GetPID(), waitpid);
+      machine->WriteRegister(2, -1);
+   }
+   else {
+      machine->WriteRegister(2, currentThread->JoinWithChild (whichChild));
+   }
+   return TRUE;
+}
+
+static bool
+SyscallFork()
+{
+   NachOSThread *child;
+
+   // Advance program counters first: the child starts from a copy of
+   // these registers.
+   AdvancePC();
+
+   // the child's pages can be evicted as well as the parent's
+   if (!swapManager->Reserve(currentThread->space->reservedSwap())) {
+      printf("[pid %d] Fork: not enough swap space.\n", currentThread->GetPID());
+      machine->WriteRegister(2, -1);
+      return FALSE;
+   }
+   child = new NachOSThread("Forked thread", GET_NICE_FROM_PARENT);
+   child->space = new ProcessAddressSpace (currentThread->space, child->GetPID());  // Duplicates the address space
+   child->SaveUserState ();		     		      // Duplicate the register set
+   child->ResetReturnValue ();			     // Sets the return register to zero
+   child->CreateThreadStack (ForkStartFunction, 0);	// Make it ready for a later context switch
+   child->Schedule ();
+   machine->WriteRegister(2, child->GetPID());		// Return value for parent
+   return FALSE;
+}
+
+static bool
+SyscallYield()
+{
+   currentThread->YieldCPU();
+   return TRUE;
+}
+
+static bool
+SyscallPrintInt()
+{
+   int printval = machine->ReadRegister(4);
+   int tempval, exp;
+
+   if (printval == 0) {
+      writeDone->P() ;
+      userConsole->PutChar('0');
+   }
+   else {
+      if (printval < 0) {
+         writeDone->P() ;
+         userConsole->PutChar('-');
+         printval = -printval;
+      }
+      tempval = printval;
+      exp=1;
+      while (tempval != 0) {
+         tempval = tempval/10;
+         exp = exp*10;
+      }
+      exp = exp/10;
+      while (exp > 0) {
+         writeDone->P() ;
+         userConsole->PutChar('0'+(printval/exp));
+         printval = printval % exp;
+         exp = exp/10;
+      }
+   }
+   return TRUE;
+}
+
+static bool
+SyscallPrintChar()
+{
+   writeDone->P() ;        // wait for previous write to finish
+   userConsole->PutChar(machine->ReadRegister(4));   // echo it!
+   return TRUE;
+}
+
+static bool
+SyscallPrintString()
+{
+   char buffer[1024];
+   int vaddr = machine->ReadRegister(4);
+   int i, length;
+
+   // Copy the string into kernel space, a bufferful at a time
+   do {
+      length = currentThread->space->CopyStringFromUser(buffer, vaddr, sizeof(buffer));
+      for (i = 0; i < length; i++) {
+         writeDone->P() ;
+         userConsole->PutChar(buffer[i]);
+      }
+      vaddr += length;
+   } while (length == (int)sizeof(buffer) - 1);
+   return TRUE;
+}
+
+static bool
+SyscallGetReg()
+{
+   machine->WriteRegister(2, machine->ReadRegister(machine->ReadRegister(4))); // Return value
+   return TRUE;
+}
+
+static bool
+SyscallGetPA()
+{
+   machine->WriteRegister(2, machine->GetPA(machine->ReadRegister(4)));  // Return value
+   return TRUE;
+}
+
+static bool
+SyscallGetPID()
+{
+   machine->WriteRegister(2, currentThread->GetPID());
+   return TRUE;
+}
+
+static bool
+SyscallGetPPID()
+{
+   machine->WriteRegister(2, currentThread->GetPPID());
+   return TRUE;
+}
+
+static bool
+SyscallSleep()
+{
+   unsigned sleeptime = machine->ReadRegister(4);
+
+   if (sleeptime == 0) {
+      // emulate a yield
+      currentThread->YieldCPU();
+   }
+   else {
+      currentThread->SortedInsertInWaitQueue (sleeptime+stats->totalTicks);
+   }
+   return TRUE;
+}
+
+static bool
+SyscallTime()
+{
+   machine->WriteRegister(2, stats->totalTicks);
+   return TRUE;
+}
+
+static bool
+SyscallPrintIntHex()
+{
+   unsigned printvalus = (unsigned)machine->ReadRegister(4);
+
+   writeDone->P() ;
+   userConsole->PutChar('0');
+   writeDone->P() ;
+   userConsole->PutChar('x');
+   if (printvalus == 0) {
+      writeDone->P() ;
+      userConsole->PutChar('0');
+   }
+   else {
+      ConvertIntToHex (printvalus, userConsole);
+   }
+   return TRUE;
+}
+
+static bool
+SyscallNumInstr()
+{
+   machine->WriteRegister(2, currentThread->GetInstructionCount());
+   return TRUE;
+}
+
+static bool
+SyscallShmAllocate()
+{
+   unsigned int mem = machine->ReadRegister(4);
+
+   machine->WriteRegister(2, currentThread->space->addSharedMemory(mem));
+   return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SyscallRingSetup
+// 	Make the submission and completion rings, of r4 entries each, in
+//	shared memory (see addSharedMemory), and return their address;
+//	0 if the size is out of range or the rings exist already.
+//----------------------------------------------------------------------
+
+static bool
+SyscallRingSetup()
+{
+   ProcessAddressSpace *space = currentThread->space;
+   int entries = machine->ReadRegister(4);
+   int size;
+
+   if ((entries <= 0) || (entries > RING_MAX_ENTRIES) || (space->ringEntries != 0)) {
+      machine->WriteRegister(2, 0);
+      return TRUE;
+   }
+   size = sizeof(RingHeader) + entries * (sizeof(RingRequest) + sizeof(RingCompletion));
+   space->ringAddr = space->addSharedMemory(size);	// zero-filled
+   space->ringEntries = entries;
+   entries = WordToMachine(entries);
+   space->CopyToUser(space->ringAddr + offsetof(RingHeader, entries), (char *)&entries,
+                     sizeof(entries));
+   DEBUG('a', "Syscall rings of %d entries at 0x%x\n", space->ringEntries, space->ringAddr);
+   machine->WriteRegister(2, space->ringAddr);
+   return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SyscallRingEnter
+// 	Run up to r4 requests queued on the submission ring (all of them
+//	if r4 is 0), in order, each through DispatchSyscall as if it had
+//	trapped with its argument in r4; stop early if the completion
+//	ring is full.  Return the number run, -1 if there are no rings
+//	or the program broke their counters.
+//
+//	The ring size is the kernel's own copy, so the program cannot
+//	make us read or write outside the rings.
+//----------------------------------------------------------------------
+
+static bool DispatchSyscall(int type);
+
+static bool
+SyscallRingEnter()
+{
+   ProcessAddressSpace *space = currentThread->space;
+   int max = machine->ReadRegister(4);
+   int entries = space->ringEntries;
+   unsigned sqAddr = space->ringAddr + sizeof(RingHeader);
+   unsigned cqAddr = sqAddr + entries * sizeof(RingRequest);
+   RingHeader ring;
+   RingRequest request;
+   RingCompletion completion;
+   int done;
+
+   if ((entries == 0)
+       || !space->CopyFromUser((char *)&ring, space->ringAddr, sizeof(ring))) {
+      machine->WriteRegister(2, -1);
+      return TRUE;
+   }
+   ring.sqHead = WordToHost(ring.sqHead);
+   ring.sqTail = WordToHost(ring.sqTail);
+   ring.cqHead = WordToHost(ring.cqHead);
+   ring.cqTail = WordToHost(ring.cqTail);
+   if ((unsigned)(ring.sqTail - ring.sqHead) > (unsigned)entries
+       || (unsigned)(ring.cqTail - ring.cqHead) > (unsigned)entries) {
+      machine->WriteRegister(2, -1);
+      return TRUE;
+   }
+
+   for (done = 0; (ring.sqHead != ring.sqTail) && ((max <= 0) || (done < max))
+                  && (ring.cqTail - ring.cqHead < entries); done++) {
+      space->CopyFromUser((char *)&request,
+                          sqAddr + (ring.sqHead % entries) * sizeof(RingRequest),
+                          sizeof(request));
+      request.type = WordToHost(request.type);
+      completion.userData = request.userData;	// stays in machine order
+      if ((request.type >= 0) && (request.type < NumSyscalls)
+          && syscallBatchable[request.type]) {
+         machine->WriteRegister(4, WordToHost(request.arg));
+         machine->WriteRegister(2, 0);
+         DispatchSyscall(request.type);
+         completion.result = WordToMachine(machine->ReadRegister(2));
+      }
+      else {
+         completion.result = WordToMachine((unsigned)-1);
+      }
+      space->CopyToUser(cqAddr + (ring.cqTail % entries) * sizeof(RingCompletion),
+                        (char *)&completion, sizeof(completion));
+      ring.sqHead++;
+      ring.cqTail++;
+   }
+
+   // hand the kernel's counters back
+   ring.sqHead = WordToMachine(ring.sqHead);
+   ring.cqTail = WordToMachine(ring.cqTail);
+   space->CopyToUser(space->ringAddr + offsetof(RingHeader, sqHead), (char *)&ring.sqHead,
+                     sizeof(ring.sqHead));
+   space->CopyToUser(space->ringAddr + offsetof(RingHeader, cqTail), (char *)&ring.cqTail,
+                     sizeof(ring.cqTail));
+   machine->WriteRegister(4, max);
+   machine->WriteRegister(2, done);
+   return TRUE;
+}
+
+//----------------------------------------------------------------------
+// InitSyscallTable
+// 	Fill in the handler of each system call we implement; the other
+//	numbers stay NULL.
+//----------------------------------------------------------------------
+
+static void
+InitSyscallTable()
+{
+   syscallTable[SysCall_Halt] = SyscallHalt;		syscallName[SysCall_Halt] = "Halt";
+   syscallTable[SysCall_Exit] = SyscallExit;		syscallName[SysCall_Exit] = "Exit";
+   syscallTable[SysCall_Exec] = SyscallExec;		syscallName[SysCall_Exec] = "Exec";
+   syscallTable[SysCall_Join] = SyscallJoin;		syscallName[SysCall_Join] = "Join";
+   syscallTable[SysCall_Fork] = SyscallFork;		syscallName[SysCall_Fork] = "Fork";
+   syscallTable[SysCall_Yield] = SyscallYield;		syscallName[SysCall_Yield] = "Yield";
+   syscallTable[SysCall_PrintInt] = SyscallPrintInt;	syscallName[SysCall_PrintInt] = "PrintInt";
+   syscallTable[SysCall_PrintChar] = SyscallPrintChar;	syscallName[SysCall_PrintChar] = "PrintChar";
+   syscallTable[SysCall_PrintString] = SyscallPrintString;
+   syscallName[SysCall_PrintString] = "PrintString";
+   syscallTable[SysCall_GetReg] = SyscallGetReg;	syscallName[SysCall_GetReg] = "GetReg";
+   syscallTable[SysCall_GetPA] = SyscallGetPA;		syscallName[SysCall_GetPA] = "GetPA";
+   syscallTable[SysCall_GetPID] = SyscallGetPID;	syscallName[SysCall_GetPID] = "GetPID";
+   syscallTable[SysCall_GetPPID] = SyscallGetPPID;	syscallName[SysCall_GetPPID] = "GetPPID";
+   syscallTable[SysCall_Sleep] = SyscallSleep;		syscallName[SysCall_Sleep] = "Sleep";
+   syscallTable[SysCall_Time] = SyscallTime;		syscallName[SysCall_Time] = "Time";
+   syscallTable[SysCall_PrintIntHex] = SyscallPrintIntHex;
+   syscallName[SysCall_PrintIntHex] = "PrintIntHex";
+   syscallTable[SysCall_ShmAllocate] = SyscallShmAllocate;
+   syscallName[SysCall_ShmAllocate] = "ShmAllocate";
+   syscallTable[SysCall_NumInstr] = SyscallNumInstr;	syscallName[SysCall_NumInstr] = "NumInstr";
+   syscallTable[SysCall_RingSetup] = SyscallRingSetup;	syscallName[SysCall_RingSetup] = "RingSetup";
+   syscallTable[SysCall_RingEnter] = SyscallRingEnter;	syscallName[SysCall_RingEnter] = "RingEnter";
+
+   // the ones that take one argument, return, and leave the PC alone
+   syscallBatchable[SysCall_Yield] = TRUE;
+   syscallBatchable[SysCall_PrintInt] = TRUE;
+   syscallBatchable[SysCall_PrintChar] = TRUE;
+   syscallBatchable[SysCall_PrintString] = TRUE;
+   syscallBatchable[SysCall_GetPA] = TRUE;
+   syscallBatchable[SysCall_GetPID] = TRUE;
+   syscallBatchable[SysCall_GetPPID] = TRUE;
+   syscallBatchable[SysCall_Sleep] = TRUE;
+   syscallBatchable[SysCall_Time] = TRUE;
+   syscallBatchable[SysCall_PrintIntHex] = TRUE;
+   syscallBatchable[SysCall_NumInstr] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// TickBucket
+// 	The histogram bucket of a call that took "ticks": 0 for none, b
+//	for 2^(b-1) up to 2^b - 1 ticks, the last one for anything longer.
+//----------------------------------------------------------------------
+
+static int
+TickBucket(int ticks)
+{
+   int bucket = 0;
+
+   while ((ticks > 0) && (bucket < NumTickBuckets - 1)) {
+      ticks >>= 1;
+      bucket++;
+   }
+   return bucket;
+}
+
+//----------------------------------------------------------------------
+// RecordSyscall
+// 	Add the ticks since the current thread made system call "type"
+//	to the statistics of that call.  Called by DispatchSyscall when
+//	the handler returns, and by the handlers of the calls that never
+//	do (Halt, Exit, Exec) just before control leaves them; only the
+//	first of these counts, as an Exec that fails does return.
+//----------------------------------------------------------------------
+
+static void
+RecordSyscall(int type)
+{
+   int ticks;
+
+   if (currentThread->syscallStartTicks == -1) {
+      return;				// recorded already
+   }
+   ticks = stats->totalTicks - currentThread->syscallStartTicks;
+   syscallTicks[type] += ticks;
+   syscallSystemTicks[type] += stats->systemTicks - currentThread->syscallStartSystemTicks;
+   syscallHistogram[type][TickBucket(ticks)]++;
+   currentThread->syscallStartTicks = -1;
+}
+
+//----------------------------------------------------------------------
+// DispatchSyscall
+// 	Run the handler of system call "type", counting the call and
+//	the ticks it takes.  Returns what the handler returned: TRUE if
+//	the PC has to be advanced past a syscall instruction.
+//
+//	The start of the call is kept in the thread, so that it survives
+//	the call blocking and the handlers that never return can record
+//	it.  A call made from the syscall ring is nested in RingEnter, so
+//	the start of the outer call is put back afterwards.
+//----------------------------------------------------------------------
+
+static bool
+DispatchSyscall(int type)
+{
+   int outerStartTicks = currentThread->syscallStartTicks;
+   int outerStartSystemTicks = currentThread->syscallStartSystemTicks;
+   bool advance;
+
+   syscallCount[type]++;
+   currentThread->syscallStartTicks = stats->totalTicks;
+   currentThread->syscallStartSystemTicks = stats->systemTicks;
+   advance = (*syscallTable[type])();
+   RecordSyscall(type);
+   currentThread->syscallStartTicks = outerStartTicks;
+   currentThread->syscallStartSystemTicks = outerStartSystemTicks;
+   return advance;
+}
+
+//----------------------------------------------------------------------
+// PrintSyscallStatistics
+// 	Print, for each system call made, how many times it was called,
+//	the ticks spent in it (all of them, and those in the kernel), and
+//	the histogram of ticks per call.
+//----------------------------------------------------------------------
+
+void
+PrintSyscallStatistics()
+{
+   int i, b;
+
+   for (i = 0; i < NumSyscalls; i++) {
+      if (syscallCount[i] == 0) continue;
+      printf("Syscall %s: calls %d, ticks %d, system ticks %d; ticks per call:",
+             syscallName[i], syscallCount[i], syscallTicks[i], syscallSystemTicks[i]);
+      for (b = 0; b < NumTickBuckets; b++) {
+         if (syscallHistogram[i][b] == 0) continue;
+         if (b == 0) printf(" 0: %d", syscallHistogram[i][b]);
+         else if (b == NumTickBuckets - 1) printf(" %d+: %d", 1 << (b - 1), syscallHistogram[i][b]);
+         else printf(" %d-%d: %d", 1 << (b - 1), (1 << b) - 1, syscallHistogram[i][b]);
+      }
+      printf("\n");
+   }
+}
+
+//----------------------------------------------------------------------
+// ExceptionHandler
+// 	Entry point into the Nachos kernel.  Called when a user program
+//	is executing, and either does a syscall, or generates an addressing
+//	or arithmetic exception.
+//
+// 	For system calls, the following is the calling convention:
+//
+// 	system call code -- r2
+//		arg1 -- r4
+//		arg2 -- r5
+//		arg3 -- r6
+//		arg4 -- r7
+//
+//	The result of the system call, if any, must be put back into r2. 
+//
+// And don't forget to increment the pc before returning. (Or else you'll
+// loop making the same system call forever!
+//
+//	"which" is the kind of exception.  The list of possible exceptions 
+//	are in machine.h.
+//----------------------------------------------------------------------
+
 void
 ExceptionHandler(ExceptionType which)
 {
     int type = machine->ReadRegister(2);
-    int memval, vaddr, printval, tempval, exp;
-    unsigned printvalus;	// Used for printing in hex
+
     if (!initializedConsoleSemaphores) {
        readAvail = new Semaphore("read avail", 0);
        writeDone = new Semaphore("write done", 1);
+       userConsole = new Console(NULL, NULL, ReadAvail, WriteDone, 0);
+       InitSyscallTable();
        initializedConsoleSemaphores = true;
     }
-    Console *console = new Console(NULL, NULL, ReadAvail, WriteDone, 0);
-    int exitcode;		// Used in SysCall_Exit
-    unsigned i;
-    char buffer[1024];		// Used in SysCall_Exec
-    int waitpid;		// Used in SysCall_Join
-    int whichChild;		// Used in SysCall_Join
-    NachOSThread *child;		// Used by SysCall_Fork
-    unsigned sleeptime;		// Used by SysCall_Sleep
-
-    if ((which == SyscallException) && (type == SysCall_Halt)) {
-	DEBUG('a', "Shutdown, initiated by user program.\n");
-   	interrupt->Halt();
-    }
-    else if ((which == SyscallException) && (type == SysCall_Exit)) {
-       exitcode = machine->ReadRegister(4);
-       printf("[pid %d]: Exit called. Code: %d\n", currentThread->GetPID(), exitcode);
-       // We do not wait for the children to finish.
-       // The children will continue to run.
-       // We will worry about this when and if we implement signals.
-       exitThreadArray[currentThread->GetPID()] = true;
-
-       // Find out if all threads have called exit
-       for (i=0; i<thread_index; i++) {
-          if (!exitThreadArray[i]) break;
-       }
-       currentThread->Exit(i==thread_index, exitcode);
-    }
-    else if ((which == SyscallException) && (type == SysCall_Exec)) {
-       // Copy the executable name into kernel space
-       vaddr = machine->ReadRegister(4);
-       while (!machine->ReadMem(vaddr, 1, &memval));
-       i = 0;
-       while ((*(char*)&memval) != '\0') {
-          buffer[i] = (*(char*)&memval);
-          i++;
-          vaddr++;
-          while (!machine->ReadMem(vaddr, 1, &memval));
-       }
-       buffer[i] = (*(char*)&memval);
-       LaunchUserProcess(buffer);
-    }
-    else if ((which == SyscallException) && (type == SysCall_Join)) {
-       waitpid = machine->ReadRegister(4);
-       // Check if this is my child. If not, return -1.
-       whichChild = currentThread->CheckIfChild (waitpid);
-       if (whichChild == -1) {
-          printf("[pid %d] Cannot join with non-existent child [pid %d].\n", currentThread->GetPID(), waitpid);
-          machine->WriteRegister(2, -1);
-          // Advance program counters.
-          machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-          machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-          machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-       }
-       else {
-          exitcode = currentThread->JoinWithChild (whichChild);
-          machine->WriteRegister(2, exitcode);
-          // Advance program counters.
-          machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-          machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-          machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-       }
-    }
-    else if ((which == SyscallException) && (type == SysCall_Fork)) {
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-       
-       child = new NachOSThread("Forked thread", GET_NICE_FROM_PARENT);
-       child->space = new ProcessAddressSpace (currentThread->space, child->GetPID());  // Duplicates the address space
-       child->SaveUserState ();		     		      // Duplicate the register set
-       child->ResetReturnValue ();			     // Sets the return register to zero
-       child->CreateThreadStack (ForkStartFunction, 0);	// Make it ready for a later context switch
-       child->Schedule ();
-       machine->WriteRegister(2, child->GetPID());		// Return value for parent
-    }
-    else if ((which == SyscallException) && (type == SysCall_Yield)) {
-       currentThread->YieldCPU();
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_PrintInt)) {
-       printval = machine->ReadRegister(4);
-       if (printval == 0) {
-          writeDone->P() ;
-          console->PutChar('0');
-       }
-       else {
-          if (printval < 0) {
-             writeDone->P() ;
-             console->PutChar('-');
-             printval = -printval;
-          }
-          tempval = printval;
-          exp=1;
-          while (tempval != 0) {
-             tempval = tempval/10;
-             exp = exp*10;
-          }
-          exp = exp/10;
-          while (exp > 0) {
-             writeDone->P() ;
-             console->PutChar('0'+(printval/exp));
-             printval = printval % exp;
-             exp = exp/10;
-          }
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_PrintChar)) {
-        writeDone->P() ;        // wait for previous write to finish
-        console->PutChar(machine->ReadRegister(4));   // echo it!
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_PrintString)) {
-       vaddr = machine->ReadRegister(4);
-       while (!machine->ReadMem(vaddr, 1, &memval));
-       while ((*(char*)&memval) != '\0') {
-          writeDone->P() ;
-          console->PutChar(*(char*)&memval);
-          vaddr++;
-          while (!machine->ReadMem(vaddr, 1, &memval));
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_GetReg)) {
-       machine->WriteRegister(2, machine->ReadRegister(machine->ReadRegister(4))); // Return value
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_GetPA)) {
-       vaddr = machine->ReadRegister(4);
-       machine->WriteRegister(2, machine->GetPA(vaddr));  // Return value
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_GetPID)) {
-       machine->WriteRegister(2, currentThread->GetPID());
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_GetPPID)) {
-       machine->WriteRegister(2, currentThread->GetPPID());
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_Sleep)) {
-       sleeptime = machine->ReadRegister(4);
-       if (sleeptime == 0) {
-          // emulate a yield
-          currentThread->YieldCPU();
-       }
-       else {
-          currentThread->SortedInsertInWaitQueue (sleeptime+stats->totalTicks);
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_Time)) {
-       machine->WriteRegister(2, stats->totalTicks);
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_PrintIntHex)) {
-       printvalus = (unsigned)machine->ReadRegister(4);
-       writeDone->P() ;
-       console->PutChar('0');
-       writeDone->P() ;
-       console->PutChar('x');
-       if (printvalus == 0) {
-          writeDone->P() ;
-          console->PutChar('0');
-       }
-       else {
-          ConvertIntToHex (printvalus, console);
-       }
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-    }
-    else if ((which == SyscallException) && (type == SysCall_NumInstr)) {
-       machine->WriteRegister(2, currentThread->GetInstructionCount());
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
-
-    }
-    else if ((which == SyscallException) && (type == SysCall_ShmAllocate)) {
-
-       unsigned int mem = machine->ReadRegister(4);
-       machine->WriteRegister(2, currentThread->space->addSharedMemory(mem));
-
-       // Advance program counters.
-       machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
-       machine->WriteRegister(PCReg, machine->ReadRegister(NextPCReg));
-       machine->WriteRegister(NextPCReg, machine->ReadRegister(NextPCReg)+4);
 
+    if ((which == SyscallException) && (type >= 0) && (type < NumSyscalls)
+        && (syscallTable[type] != NULL)) {
+       if (DispatchSyscall(type)) {
+          AdvancePC();
+       }
     } else if (which == PageFaultException) {
       unsigned vAddr = machine->ReadRegister(BadVAddrReg);      
+      if ((machine->tlb != NULL) && currentThread->space->refillTLB(vAddr))
+        return;				// only a TLB miss
+      if (loadController != NULL)
+        loadController->CheckSuspend();	// may sleep until reactivated
       currentThread->space->fixPageFault(vAddr);
+      if (machine->tlb != NULL)
+        currentThread->space->refillTLB(vAddr);	// unless evicted meanwhile
+    } else if ((which == ReadOnlyException)
+               && currentThread->space->fixCopyOnWrite(machine->ReadRegister(BadVAddrReg))) {
+      // first write to a page shared by fork; retry the instruction
     } else {
 	printf("Unexpected user mode exception %d %d\n", which, type);
 	ASSERT(FALSE);
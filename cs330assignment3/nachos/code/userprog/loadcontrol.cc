@@ -0,0 +1,239 @@
+// loadcontrol.cc
+//	Routines for load control.  See loadcontrol.h for an overview.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "loadcontrol.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// LoadController::LoadController
+// 	Initialize load control, with no process deactivated.
+//----------------------------------------------------------------------
+
+LoadController::LoadController()
+{
+    int i;
+
+    suspended = new List;
+    isSuspended = new bool[MAX_THREAD_COUNT];
+    pending = new bool[MAX_THREAD_COUNT];
+    peakWorkingSet = new int[MAX_THREAD_COUNT];
+    lastWorkingSet = new int[MAX_THREAD_COUNT];
+    numSuspensions = new int[MAX_THREAD_COUNT];
+    for (i = 0; i < MAX_THREAD_COUNT; i++) {
+	isSuspended[i] = pending[i] = FALSE;
+	peakWorkingSet[i] = lastWorkingSet[i] = numSuspensions[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// LoadController::~LoadController
+// 	De-allocate load control.
+//----------------------------------------------------------------------
+
+LoadController::~LoadController()
+{
+    delete suspended;
+    delete [] isSuspended;
+    delete [] pending;
+    delete [] peakWorkingSet;
+    delete [] lastWorkingSet;
+    delete [] numSuspensions;
+}
+
+//----------------------------------------------------------------------
+// LoadController::Sample
+// 	Called at each timer interrupt taken in user mode, with
+//	interrupts off.  If the window of the running process is over,
+//	record its new working set, and see whether the load has changed
+//	enough to deactivate or reactivate a process.
+//----------------------------------------------------------------------
+
+void
+LoadController::Sample()
+{
+    ProcessAddressSpace *space = currentThread->space;
+    int pid = currentThread->GetPID();
+
+    if ((space == NULL)
+	|| !space->sampleWorkingSet(currentThread->GetInstructionCount()))
+	return;
+    lastWorkingSet[pid] = space->workingSetSize();
+    if (lastWorkingSet[pid] > peakWorkingSet[pid])
+	peakWorkingSet[pid] = lastWorkingSet[pid];
+    if (pending[pid] && (space->faultRate() <= LOAD_CONTROL_FAULTS))
+	pending[pid] = FALSE;		// settled down before its next fault
+    DEBUG('v', "pid %d: working set %d pages, %d faults\n", pid,
+	lastWorkingSet[pid], space->faultRate());
+    Balance(NULL);
+}
+
+//----------------------------------------------------------------------
+// LoadController::CheckSuspend
+// 	Called on a page fault, before it is served.  If the running
+//	process was chosen for deactivation, and is still not the only
+//	active one, put it to sleep until it is reactivated; the fault
+//	is served then.
+//----------------------------------------------------------------------
+
+void
+LoadController::CheckSuspend()
+{
+    int pid = currentThread->GetPID();
+    int numActive;
+    bool thrashing;
+    IntStatus oldLevel;
+
+    if (!pending[pid])
+	return;
+    oldLevel = interrupt->SetLevel(IntOff);
+    pending[pid] = FALSE;
+    (void) ActiveLoad(NULL, &numActive, &thrashing);
+    if (numActive > 1) {
+	DEBUG('v', "Load control: deactivating pid %d\n", pid);
+	isSuspended[pid] = TRUE;
+	numSuspensions[pid]++;
+	stats->loadControlSuspensions++;
+	suspended->Append((void *) currentThread);
+	currentThread->PutThreadToSleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// LoadController::ProcessExited
+// 	"thread" is exiting, with interrupts off, and no longer counts
+//	towards the load: a deactivated process may fit now.
+//----------------------------------------------------------------------
+
+void
+LoadController::ProcessExited(NachOSThread *thread)
+{
+    pending[thread->GetPID()] = FALSE;
+    Balance(thread);
+}
+
+//----------------------------------------------------------------------
+// LoadController::Idle
+// 	Called at the timer interrupts of an idle CPU.  Every active
+//	process is blocked, perhaps on one that is deactivated, so bring
+//	one back whatever the load.
+//----------------------------------------------------------------------
+
+void
+LoadController::Idle()
+{
+    if (!suspended->IsEmpty())
+	Reactivate();
+}
+
+//----------------------------------------------------------------------
+// LoadController::Print
+// 	Print the working set estimates of every process, and how often
+//	each was deactivated.  The totals are in Statistics::Print.
+//----------------------------------------------------------------------
+
+void
+LoadController::Print()
+{
+    unsigned i;
+
+    printf("Working sets:\n");
+    for (i = 0; i < thread_index; i++)
+	if (peakWorkingSet[i] > 0)
+	    printf("\tpid %d: working set last %d, peak %d pages; suspended %d times\n",
+		i, lastWorkingSet[i], peakWorkingSet[i], numSuspensions[i]);
+}
+
+//----------------------------------------------------------------------
+// LoadController::ActiveLoad
+// 	Add up the working sets of the active processes, leaving out
+//	"except" (NULL for none).
+//
+//	"numActive" is set to the number of active processes, and
+//	"thrashing" to whether any of them faults more than
+//	LOAD_CONTROL_FAULTS times a window.
+//----------------------------------------------------------------------
+
+int
+LoadController::ActiveLoad(NachOSThread *except, int *numActive, bool *thrashing)
+{
+    NachOSThread *thread;
+    unsigned i;
+    int load = 0;
+
+    *numActive = 0;
+    *thrashing = FALSE;
+    for (i = 0; i < thread_index; i++) {
+	thread = threadArray[i];
+	if (exitThreadArray[i] || isSuspended[i] || (thread == except)
+		|| (thread == NULL) || (thread->space == NULL))
+	    continue;
+	(*numActive)++;
+	load += thread->space->workingSetSize();
+	if (thread->space->faultRate() > LOAD_CONTROL_FAULTS)
+	    *thrashing = TRUE;
+    }
+    return load;
+}
+
+//----------------------------------------------------------------------
+// LoadController::Balance
+// 	If the active processes are thrashing, with more working set than
+//	memory, choose the youngest of them for deactivation.  Otherwise
+//	reactivate the oldest deactivated process if its working set
+//	fits, or if no process is active.  "except" is an exiting thread.
+//----------------------------------------------------------------------
+
+void
+LoadController::Balance(NachOSThread *except)
+{
+    NachOSThread *oldest;
+    int load, numActive, i, youngest = -1;
+    bool thrashing;
+
+    load = ActiveLoad(except, &numActive, &thrashing);
+    if ((load > NumPhysPages) && thrashing && (numActive > 1)) {
+	for (i = thread_index - 1; i >= 0; i--) {
+	    if (pending[i])
+		return;			// one at a time
+	    if ((youngest == -1) && !exitThreadArray[i] && !isSuspended[i]
+		    && (threadArray[i] != except) && (threadArray[i] != NULL)
+		    && (threadArray[i]->space != NULL))
+		youngest = i;
+	}
+	DEBUG('v', "Load control: %d pages of working set, pid %d chosen\n",
+	    load, youngest);
+	pending[youngest] = TRUE;
+	return;
+    }
+    if (suspended->IsEmpty())
+	return;
+    oldest = (NachOSThread *) suspended->Remove();
+    suspended->Prepend((void *) oldest);
+    if ((numActive == 0)
+	|| (load + lastWorkingSet[oldest->GetPID()] <= NumPhysPages))
+	Reactivate();
+}
+
+//----------------------------------------------------------------------
+// LoadController::Reactivate
+// 	Put the process deactivated longest ago back on the ready queue.
+//	Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+LoadController::Reactivate()
+{
+    NachOSThread *thread = (NachOSThread *) suspended->Remove();
+
+    ASSERT(thread != NULL);
+    DEBUG('v', "Load control: reactivating pid %d\n", thread->GetPID());
+    isSuspended[thread->GetPID()] = FALSE;
+    stats->loadControlReactivations++;
+    scheduler->MoveThreadToReadyQueue(thread);
+}
@@ -0,0 +1,60 @@
+// loadcontrol.h
+//	Data structures for load control: a medium-term scheduler that
+//	deactivates whole processes when their working sets no longer
+//	fit in memory, so that the others stop thrashing.
+//
+//	Each address space estimates its working set over a window of its
+//	own virtual time (ProcessAddressSpace::sampleWorkingSet): the pages
+//	whose use bit was set during the last window, and the faults it
+//	took in it.  When the working sets of the active processes add up
+//	to more than NumPhysPages and some of them fault more than
+//	LOAD_CONTROL_FAULTS times a window, the youngest active process is
+//	chosen for deactivation.  It is taken off the CPU at its next page
+//	fault, where it holds no kernel locks, and its pages are then left
+//	to page replacement.
+//
+//	A deactivated process comes back, oldest first, when its last
+//	working set fits beside those of the active processes, when no
+//	other process is left active, or when the CPU would otherwise be
+//	idle -- so a parent waiting for a deactivated child to exit does
+//	not wait forever.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef LOADCONTROL_H
+#define LOADCONTROL_H
+
+#include "copyright.h"
+#include "list.h"
+#include "thread.h"
+
+class LoadController {
+  public:
+    LoadController();			// all processes active
+    ~LoadController();
+
+    void Sample();			// timer: update the working set of
+					// the running process, and rebalance
+    void CheckSuspend();		// page fault: deactivate the running
+					// process, if it was chosen
+    void ProcessExited(NachOSThread *thread);	// its frames are free
+    void Idle();			// nothing to run: bring one back
+
+    void Print();			// per-process working sets
+
+  private:
+    List *suspended;			// deactivated threads, oldest first
+    bool *isSuspended;			// indexed by pid
+    bool *pending;			// chosen, deactivated at next fault
+    int *peakWorkingSet;		// largest estimate seen
+    int *lastWorkingSet;		// latest estimate
+    int *numSuspensions;		// times deactivated
+
+    int ActiveLoad(NachOSThread *except, int *numActive, bool *thrashing);
+    void Balance(NachOSThread *except);	// deactivate or reactivate one
+    void Reactivate();			// the oldest deactivated process
+};
+
+#endif // LOADCONTROL_H
@@ -0,0 +1,161 @@
+// pagecache.cc
+//	Routines to manage the cache of executable pages.  See
+//	pagecache.h for an overview.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pagecache.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// PageCache::PageCache
+// 	Initialize an empty cache, with no executables open.
+//----------------------------------------------------------------------
+
+PageCache::PageCache()
+{
+    int i;
+
+    maxFiles = 8;
+    numFiles = 0;
+    names = new char *[maxFiles];
+    files = new OpenFile *[maxFiles];
+    for (i = 0; i < NumPageCacheBuckets; i++)
+	buckets[i] = -1;
+    for (i = 0; i < NumPhysPages; i++)
+	chain[i] = fileOf[i] = offsetOf[i] = -1;
+}
+
+//----------------------------------------------------------------------
+// PageCache::~PageCache
+// 	Close the executables.  The frames are the machine's.
+//----------------------------------------------------------------------
+
+PageCache::~PageCache()
+{
+    int i;
+
+    for (i = 0; i < numFiles; i++) {
+	delete [] names[i];
+	delete files[i];
+    }
+    delete [] names;
+    delete [] files;
+}
+
+//----------------------------------------------------------------------
+// PageCache::OpenExecutable
+// 	Find the number of an executable, by name, opening it if this is
+//	the first address space to run it.  The file stays open for good.
+//
+// Returns:
+//	The number of the executable, -1 if it cannot be opened.
+//----------------------------------------------------------------------
+
+int
+PageCache::OpenExecutable(char *fileName)
+{
+    OpenFile *file;
+    char **newNames;
+    OpenFile **newFiles;
+    int i;
+
+    for (i = 0; i < numFiles; i++)
+	if (!strcmp(names[i], fileName))
+	    return i;
+
+    file = fileSystem->Open(fileName);
+    if (file == NULL)
+	return -1;
+    if (numFiles == maxFiles) {		// grow the table
+	newNames = new char *[2 * maxFiles];
+	newFiles = new OpenFile *[2 * maxFiles];
+	for (i = 0; i < numFiles; i++) {
+	    newNames[i] = names[i];
+	    newFiles[i] = files[i];
+	}
+	delete [] names;
+	delete [] files;
+	names = newNames;
+	files = newFiles;
+	maxFiles *= 2;
+    }
+    names[numFiles] = new char[strlen(fileName) + 1];
+    strcpy(names[numFiles], fileName);
+    files[numFiles] = file;
+    DEBUG('w', "Page cache: executable %d is %s\n", numFiles, fileName);
+    return numFiles++;
+}
+
+//----------------------------------------------------------------------
+// PageCache::Lookup
+// 	Find the frame caching the page at "offset" in executable "file".
+//
+// Returns:
+//	The frame, -1 if the page is not cached.
+//----------------------------------------------------------------------
+
+int
+PageCache::Lookup(int file, int offset)
+{
+    int frame;
+
+    for (frame = buckets[Hash(file, offset)]; frame != -1; frame = chain[frame])
+	if ((fileOf[frame] == file) && (offsetOf[frame] == offset))
+	    return frame;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// PageCache::Insert
+// 	Remember that "frame" now holds the page at "offset" in
+//	executable "file".  The page must not be cached already.
+//----------------------------------------------------------------------
+
+void
+PageCache::Insert(int file, int offset, int frame)
+{
+    int bucket = Hash(file, offset);
+
+    ASSERT(fileOf[frame] == -1);
+    ASSERT(Lookup(file, offset) == -1);
+    fileOf[frame] = file;
+    offsetOf[frame] = offset;
+    chain[frame] = buckets[bucket];
+    buckets[bucket] = frame;
+    machine->frameTable->Frame(frame)->flags |= FrameCached;
+}
+
+//----------------------------------------------------------------------
+// PageCache::Remove
+// 	Forget the page cached in "frame", which page replacement is
+//	about to reuse.
+//----------------------------------------------------------------------
+
+void
+PageCache::Remove(int frame)
+{
+    int *link;
+
+    ASSERT(fileOf[frame] != -1);
+    for (link = &buckets[Hash(fileOf[frame], offsetOf[frame])]; *link != frame;
+		link = &chain[*link])
+	ASSERT(*link != -1);
+    *link = chain[frame];
+    chain[frame] = fileOf[frame] = offsetOf[frame] = -1;
+    machine->frameTable->Frame(frame)->flags &= ~FrameCached;
+}
+
+//----------------------------------------------------------------------
+// PageCache::Hash
+// 	The chain a page is on.
+//----------------------------------------------------------------------
+
+int
+PageCache::Hash(int file, int offset)
+{
+    return (unsigned)(file * 7919 + offset / PageSize) % NumPageCacheBuckets;
+}
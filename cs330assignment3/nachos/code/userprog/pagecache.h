@@ -0,0 +1,59 @@
+// pagecache.h
+//	Data structures for the kernel-wide cache of executable pages.
+//
+//	A page of code or initialized data read from an executable is
+//	kept in its frame, under the name (executable, virtual address), so
+//	that every address space running the same program maps that one
+//	frame instead of reading its own copy.  The mappings are read-only
+//	and copy-on-write: a process that writes to an initialized data
+//	page gets a private copy (see ProcessAddressSpace::fixCopyOnWrite),
+//	so cached frames are never dirty and can be dropped at any time.
+//
+//	A cached frame stays cached when the last address space mapping
+//	it goes away; it is only dropped when page replacement picks it.
+//
+//	The open file of each executable is also kept, so that page faults
+//	do not have to open the file again.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include "copyright.h"
+#include "filesys.h"
+#include "machine.h"
+
+#define NumPageCacheBuckets	31	// hash buckets for (file, offset)
+
+class PageCache {
+  public:
+    PageCache();			// empty to start with
+    ~PageCache();			// closes the executables
+
+    int OpenExecutable(char *fileName);	// number of the executable,
+					// opening it the first time;
+					// -1 if it cannot be opened
+    OpenFile *Executable(int file) { return files[file]; }
+
+    int Lookup(int file, int offset);	// frame caching the page, or -1
+    void Insert(int file, int offset, int frame);
+					// "frame" holds the page now
+    void Remove(int frame);		// "frame" is being reused
+
+  private:
+    char **names;			// the executables, by number
+    OpenFile **files;
+    int numFiles, maxFiles;
+
+    int buckets[NumPageCacheBuckets];	// first cached frame of each chain
+    int chain[NumPhysPages];		// next frame in the same chain
+    int fileOf[NumPhysPages];		// page cached in each frame
+    int offsetOf[NumPhysPages];
+
+    int Hash(int file, int offset);
+};
+
+#endif // PAGECACHE_H
@@ -0,0 +1,170 @@
+// pageout.cc
+//	Routines for the page-out daemon.  See pageout.h for an overview.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pageout.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// PageoutThread
+// 	The function the daemon thread runs.  "arg" is the daemon.
+//----------------------------------------------------------------------
+
+static void
+PageoutThread(int arg)
+{
+    ((PageoutDaemon *) arg)->Run();
+}
+
+//----------------------------------------------------------------------
+// PageoutDaemon::PageoutDaemon
+// 	Start the daemon thread.  It is a kernel thread, not a process,
+//	so no one waits for it to exit.
+//----------------------------------------------------------------------
+
+PageoutDaemon::PageoutDaemon()
+{
+    wakeup = new Semaphore("page-out wakeup", 0);
+    wakeupPending = cleanPending = FALSE;
+    thread = new NachOSThread("page-out daemon");
+    thread->ThreadFork(PageoutThread, (int) this);
+}
+
+//----------------------------------------------------------------------
+// PageoutDaemon::~PageoutDaemon
+// 	Called when Nachos halts; the daemon thread just stops with it.
+//----------------------------------------------------------------------
+
+PageoutDaemon::~PageoutDaemon()
+{
+    delete wakeup;
+}
+
+//----------------------------------------------------------------------
+// PageoutDaemon::Wakeup
+// 	Ask the daemon to free some frames.  May be called from an
+//	interrupt handler.
+//----------------------------------------------------------------------
+
+void
+PageoutDaemon::Wakeup()
+{
+    if (!wakeupPending) {
+	wakeupPending = TRUE;
+	wakeup->V();
+    }
+}
+
+//----------------------------------------------------------------------
+// PageoutDaemon::Idle
+// 	Called at the timer interrupts of an idle CPU: ask the daemon to
+//	clean a batch of pages.
+//----------------------------------------------------------------------
+
+void
+PageoutDaemon::Idle()
+{
+    cleanPending = TRUE;
+    Wakeup();
+}
+
+//----------------------------------------------------------------------
+// PageoutDaemon::Run
+// 	Wait for work, and do it.  Once every process has exited, halt:
+//	the daemon may be the thread that would otherwise idle forever.
+//----------------------------------------------------------------------
+
+void
+PageoutDaemon::Run()
+{
+    unsigned i;
+    bool clean;
+
+    for (;;) {
+	wakeup->P();
+	wakeupPending = FALSE;
+	clean = cleanPending;
+	cleanPending = FALSE;
+
+	for (i = 0; i < thread_index; i++)
+	    if (!exitThreadArray[i])
+		break;
+	if (i == thread_index) {
+	    printf("\nNo threads ready or runnable, and no pending interrupts.\n");
+	    printf("Assuming all programs completed.\n");
+	    interrupt->Halt();
+	}
+	if (pageReplacementAlgo == 0)
+	    continue;			// nothing can be evicted
+
+	swapManager->AcquirePaging();
+	if (NumPhysPages - numPagesAllocated < PAGEOUT_LOW_WATER)
+	    Reclaim();
+	if (clean)
+	    Clean();
+	swapManager->ReleasePaging();
+    }
+}
+
+//----------------------------------------------------------------------
+// PageoutDaemon::Reclaim
+// 	Evict pages until PAGEOUT_HIGH_WATER frames are free, or nothing
+//	else can be evicted, and let threads waiting for a frame retry.
+//----------------------------------------------------------------------
+
+void
+PageoutDaemon::Reclaim()
+{
+    int frame;
+
+    while ((NumPhysPages - numPagesAllocated < PAGEOUT_HIGH_WATER)
+	    && machine->frameTable->HasVictim(-1)) {
+	frame = ProcessAddressSpace::chooseVictim(-1, -1, 0);
+	ProcessAddressSpace::evictFrame(frame);
+	ProcessAddressSpace::freeFrame(frame);
+	stats->pageoutReclaims++;
+    }
+    swapManager->PageInDone();
+}
+
+//----------------------------------------------------------------------
+// PageoutDaemon::Clean
+// 	Write out up to PAGEOUT_CLEAN_BATCH dirty private pages, taken
+//	from the front of the active list.  The candidates are chosen
+//	before any write, since processes exiting during a write free
+//	their frames; each is checked again just before it is written.
+//----------------------------------------------------------------------
+
+void
+PageoutDaemon::Clean()
+{
+    FrameTable *frames = machine->frameTable;
+    FrameDescriptor *f;
+    int candidate[PAGEOUT_CLEAN_BATCH], owner[PAGEOUT_CLEAN_BATCH];
+    int vpn[PAGEOUT_CLEAN_BATCH];
+    int frame, n = 0, i;
+
+    for (frame = frames->FirstActive(); (frame != -1) && (n < PAGEOUT_CLEAN_BATCH);
+		frame = frames->Frame(frame)->next) {
+	f = frames->Frame(frame);
+	if ((f->owner == -1) || (f->refCount > 1) || (f->flags & FrameCached)
+		|| !threadArray[f->owner]->space->GetPageTable()[f->vpn].dirty)
+	    continue;
+	candidate[n] = frame;
+	owner[n] = f->owner;
+	vpn[n] = f->vpn;
+	n++;
+    }
+    for (i = 0; i < n; i++) {
+	f = frames->Frame(candidate[i]);
+	if (exitThreadArray[owner[i]] || !frames->IsReplaceable(candidate[i])
+		|| (f->owner != owner[i]) || (f->vpn != vpn[i]))
+	    continue;
+	if (threadArray[owner[i]]->space->cleanPage(vpn[i], candidate[i]))
+	    stats->pageoutCleans++;
+    }
+}
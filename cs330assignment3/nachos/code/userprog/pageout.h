@@ -0,0 +1,48 @@
+// pageout.h
+//	Data structures for the page-out daemon, a kernel thread that
+//	keeps some frames free, so that page faults do not usually have
+//	to evict a page, and write it out, before they can read theirs.
+//
+//	The daemon sleeps until a fault leaves fewer than PAGEOUT_LOW_WATER
+//	frames free; it then evicts pages, with the replacement algorithm
+//	in use, until PAGEOUT_HIGH_WATER frames are free.  When the CPU has
+//	nothing else to do, it also writes out up to PAGEOUT_CLEAN_BATCH
+//	dirty pages from the front of the active list, which are the next
+//	ones FIFO and LRU replace, leaving them resident but clean, so that
+//	evicting them later needs no write.
+//
+//	The daemon does all this holding the paging lock, like any other
+//	page replacement.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGEOUT_H
+#define PAGEOUT_H
+
+#include "copyright.h"
+#include "synch.h"
+#include "thread.h"
+
+class PageoutDaemon {
+  public:
+    PageoutDaemon();			// fork the daemon thread
+    ~PageoutDaemon();
+
+    void Wakeup();			// few frames are free
+    void Idle();			// the CPU is idle: clean some pages
+
+    void Run();			// the daemon thread's body
+
+  private:
+    NachOSThread *thread;
+    Semaphore *wakeup;			// the daemon waits here for work
+    bool wakeupPending;			// wakeup has been signalled
+    bool cleanPending;			// ... by Idle
+
+    void Reclaim();			// free frames up to the high mark
+    void Clean();			// write out a batch of dirty pages
+};
+
+#endif // PAGEOUT_H
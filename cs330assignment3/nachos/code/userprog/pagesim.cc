@@ -0,0 +1,409 @@
+// pagesim.cc
+//	A UNIX program (not part of Nachos) to replay a page reference
+//	trace recorded with "nachos -T file" (see trace.h) under Belady's
+//	optimal policy and under each of the page replacement policies
+//	Nachos implements, for a range of memory sizes.
+//
+//	Usage: pagesim trace [minFrames [maxFrames]]
+//
+//	It prints the number of page faults of each policy for every
+//	number of frames from minFrames to maxFrames.  OPT evicts the page
+//	whose next reference is farthest in the future, so no policy can
+//	fault less: it is the lower bound the others are measured against.
+//
+//	The model is plain demand paging over one pool of frames shared
+//	by all processes, as in Nachos, and each policy is simulated the
+//	way Nachos runs it.  Nachos itself also pins shared memory, shares
+//	executable pages between processes and reads ahead on faults, so
+//	its own fault counts differ; the gaps between policies on the same
+//	references are what this program is for.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "copyright.h"
+#include "trace.h"
+
+// The policies, numbered as for "nachos -R", with OPT as 0.
+#define OPT		0
+#define RANDOM		1
+#define FIFO		2
+#define LRU		3
+#define LRU_CLOCK	4
+#define TWO_HANDED_CLOCK 5
+#define ARC		6
+#define TWO_Q		7
+#define NumPolicies	8
+
+static char *policyName[NumPolicies] =
+    { "OPT", "RANDOM", "FIFO", "LRU", "CLOCK", "2CLOCK", "ARC", "2Q" };
+
+#define DefaultMinFrames	2
+#define DefaultMaxFrames	32	// Nachos has NumPhysPages = 15
+
+// The trace, with each (pid, vpn) renamed to a dense page number.
+static int numRefs;
+static int *page;		// page of each reference
+static int *nextUse;		// index of the next reference to the same
+				// page, numRefs if there is none
+static int numPages;
+static int numWrites;
+
+// Simulation state, per frame and per page.
+static int numFrames;
+static int *framePage;		// page in each frame, -1 if free
+static int *loadTime;		// reference that brought the page in
+static int *lastUse;		// latest reference to it
+static int *nextRef;		// next reference to it (OPT)
+static char *refBit;		// reference bit (clock algorithms)
+static int *listOf;		// ARC and 2Q: 1 for T1/A1in, 2 for T2/Am
+static int *stamp;		// ... and when it went to the young end
+static int *residentIn;		// frame holding each page, -1 if none
+static char *ghostOf;		// ARC and 2Q: 1 for B1/A1out, 2 for B2
+static int *ghostStamp;		// ... and when it was evicted
+static int hand;			// clock algorithms
+static int length[3], ghostLength[3], target, clock;
+
+//----------------------------------------------------------------------
+// ReadTrace
+// 	Read a trace file, renaming its pages, and work out for each
+//	reference when its page is used next.
+//----------------------------------------------------------------------
+
+static void
+ReadTrace(char *fileName)
+{
+    FILE *fp = fopen(fileName, "rb");
+    unsigned int magic, *refs, *keys;
+    int *last, tableSize, i, h;
+    long size;
+
+    if (fp == NULL) {
+	perror(fileName);
+	exit(1);
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if ((fread(&magic, sizeof(magic), 1, fp) != 1) || (magic != TRACE_MAGIC)) {
+	fprintf(stderr, "%s: not a Nachos page reference trace\n", fileName);
+	exit(1);
+    }
+    numRefs = (size - sizeof(magic)) / sizeof(unsigned int);
+    refs = new unsigned int[numRefs + 1];
+    if ((int) fread(refs, sizeof(unsigned int), numRefs, fp) != numRefs) {
+	fprintf(stderr, "%s: short read\n", fileName);
+	exit(1);
+    }
+    fclose(fp);
+
+    // rename the pages, with an open hash table on (pid, vpn)
+    for (tableSize = 64; tableSize < 2 * numRefs; tableSize *= 2)
+	;
+    keys = new unsigned int[tableSize];
+    int *numberOf = new int[tableSize];
+    for (i = 0; i < tableSize; i++)
+	numberOf[i] = -1;
+    page = new int[numRefs + 1];
+    numPages = numWrites = 0;
+    for (i = 0; i < numRefs; i++) {
+	unsigned int key = TracePage(refs[i]);
+
+	for (h = (key * 2654435761u) & (tableSize - 1);
+		(numberOf[h] != -1) && (keys[h] != key); h = (h + 1) & (tableSize - 1))
+	    ;
+	if (numberOf[h] == -1) {
+	    keys[h] = key;
+	    numberOf[h] = numPages++;
+	}
+	page[i] = numberOf[h];
+	if (TraceIsWrite(refs[i]))
+	    numWrites++;
+    }
+    delete [] numberOf;
+    delete [] keys;
+    delete [] refs;
+
+    nextUse = new int[numRefs + 1];
+    last = new int[numPages + 1];
+    for (i = 0; i < numPages; i++)
+	last[i] = numRefs;
+    for (i = numRefs - 1; i >= 0; i--) {
+	nextUse[i] = last[page[i]];
+	last[page[i]] = i;
+    }
+    delete [] last;
+}
+
+//----------------------------------------------------------------------
+// Oldest
+// 	The frame that has been on ARC/2Q list "list" longest, -1 if the
+//	list is empty.
+//----------------------------------------------------------------------
+
+static int
+Oldest(int list)
+{
+    int f, oldest = -1;
+
+    for (f = 0; f < numFrames; f++)
+	if ((listOf[f] == list) && ((oldest == -1) || (stamp[f] < stamp[oldest])))
+	    oldest = f;
+    return oldest;
+}
+
+//----------------------------------------------------------------------
+// RemoveOldestGhost
+// 	Forget the page evicted longest ago from ghost list "list".
+//----------------------------------------------------------------------
+
+static void
+RemoveOldestGhost(int list)
+{
+    int p, oldest = -1;
+
+    for (p = 0; p < numPages; p++)
+	if ((ghostOf[p] == list) &&
+		((oldest == -1) || (ghostStamp[p] < ghostStamp[oldest])))
+	    oldest = p;
+    ghostOf[oldest] = 0;
+    ghostLength[list]--;
+}
+
+//----------------------------------------------------------------------
+// ToList
+// 	Put frame "f" at the young end of ARC/2Q list "list".
+//----------------------------------------------------------------------
+
+static void
+ToList(int f, int list)
+{
+    if (listOf[f] != 0)
+	length[listOf[f]]--;
+    listOf[f] = list;
+    stamp[f] = clock++;
+    length[list]++;
+}
+
+//----------------------------------------------------------------------
+// Victim
+// 	The frame "policy" evicts when every frame is in use, at
+//	a reference to page "p".  For ARC and 2Q the evicted page is
+//	also remembered in a ghost list, as AdaptiveReplacement::Victim
+//	does.
+//----------------------------------------------------------------------
+
+static int
+Victim(int policy, int p)
+{
+    int f, victim = 0, from;
+
+    switch (policy) {
+      case OPT:
+	for (f = 1; f < numFrames; f++)
+	    if (nextRef[f] > nextRef[victim])
+		victim = f;
+	break;
+      case RANDOM:
+	victim = random() % numFrames;
+	break;
+      case FIFO:
+      case LRU:
+	for (f = 1; f < numFrames; f++)
+	    if ((policy == FIFO) ? (loadTime[f] < loadTime[victim])
+			: (lastUse[f] < lastUse[victim]))
+		victim = f;
+	break;
+      case LRU_CLOCK:
+	while (refBit[hand]) {
+	    refBit[hand] = 0;
+	    hand = (hand + 1) % numFrames;
+	}
+	victim = hand;
+	hand = (hand + 1) % numFrames;
+	break;
+      case TWO_HANDED_CLOCK:
+	for (;;) {
+	    refBit[(hand + numFrames / 2) % numFrames] = 0;
+	    if (!refBit[hand])
+		break;
+	    hand = (hand + 1) % numFrames;
+	}
+	victim = hand;
+	hand = (hand + 1) % numFrames;
+	break;
+      case ARC:
+      case TWO_Q:
+	if (policy == ARC)
+	    from = ((length[1] > 0) && ((length[1] > target) ||
+		((length[1] == target) && (ghostOf[p] == 2)))) ? 1 : 2;
+	else
+	    from = (length[1] > ((numFrames / 4 > 1) ? numFrames / 4 : 1)) ? 1 : 2;
+	if (length[from] == 0)
+	    from = 3 - from;
+	victim = Oldest(from);
+	length[from]--;
+	listOf[victim] = 0;
+	if ((from == 1) || (policy == ARC)) {
+	    ghostOf[framePage[victim]] = from;
+	    ghostStamp[framePage[victim]] = clock++;
+	    ghostLength[from]++;
+	}
+	if (policy == ARC) {
+	    while ((ghostLength[1] > 0) && (length[1] + ghostLength[1] > numFrames))
+		RemoveOldestGhost(1);
+	    while (length[1] + length[2] + ghostLength[1] + ghostLength[2]
+			> 2 * numFrames)
+		RemoveOldestGhost((ghostLength[2] > 0) ? 2 : 1);
+	} else {
+	    while (ghostLength[1] > ((numFrames / 2 > 1) ? numFrames / 2 : 1))
+		RemoveOldestGhost(1);
+	}
+	break;
+    }
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// Inserted
+// 	ARC and 2Q: page "p" has just been brought into frame "f".  As in
+//	AdaptiveReplacement::Inserted, a page found in a ghost list goes
+//	to the second list, and ARC moves its target.
+//----------------------------------------------------------------------
+
+static void
+Inserted(int policy, int f, int p)
+{
+    int step;
+
+    if (ghostOf[p] == 1) {
+	ghostOf[p] = 0;
+	ghostLength[1]--;
+	if (policy == ARC) {
+	    step = ghostLength[2] / (ghostLength[1] + 1);
+	    target += (step > 1) ? step : 1;
+	    if (target > numFrames)
+		target = numFrames;
+	}
+	ToList(f, 2);
+    } else if ((policy == ARC) && (ghostOf[p] == 2)) {
+	ghostOf[p] = 0;
+	ghostLength[2]--;
+	step = ghostLength[1] / (ghostLength[2] + 1);
+	target -= (step > 1) ? step : 1;
+	if (target < 0)
+	    target = 0;
+	ToList(f, 2);
+    } else
+	ToList(f, 1);
+}
+
+//----------------------------------------------------------------------
+// Simulate
+// 	Replay the trace under "policy" with "frames" frames.
+//
+// Returns:
+//	The number of page faults.
+//----------------------------------------------------------------------
+
+static int
+Simulate(int policy, int frames)
+{
+    int i, f, p, faults = 0, used = 0;
+
+    numFrames = frames;
+    for (f = 0; f < numFrames; f++) {
+	framePage[f] = -1;
+	refBit[f] = 0;
+	listOf[f] = 0;
+    }
+    for (p = 0; p < numPages; p++) {
+	residentIn[p] = -1;
+	ghostOf[p] = 0;
+    }
+    for (i = 0; i < 3; i++)
+	length[i] = ghostLength[i] = 0;
+    target = clock = hand = 0;
+    srandom(1);
+
+    for (i = 0; i < numRefs; i++) {
+	p = page[i];
+	f = residentIn[p];
+	if (f == -1) {
+	    faults++;
+	    if (used < numFrames)
+		f = used++;
+	    else {
+		f = Victim(policy, p);
+		residentIn[framePage[f]] = -1;
+	    }
+	    framePage[f] = p;
+	    residentIn[p] = f;
+	    loadTime[f] = i;
+	    if ((policy == ARC) || (policy == TWO_Q))
+		Inserted(policy, f, p);
+	} else if ((policy == ARC) || ((policy == TWO_Q) && (listOf[f] == 2)))
+	    ToList(f, 2);
+	lastUse[f] = i;
+	nextRef[f] = nextUse[i];
+	refBit[f] = 1;
+    }
+    return faults;
+}
+
+//----------------------------------------------------------------------
+// main
+// 	Read the trace, and print the faults of every policy for each
+//	number of frames asked for.
+//----------------------------------------------------------------------
+
+int
+main(int argc, char **argv)
+{
+    int minFrames = DefaultMinFrames, maxFrames = DefaultMaxFrames;
+    int frames, policy;
+
+    if ((argc < 2) || (argc > 4)) {
+	fprintf(stderr, "usage: %s trace [minFrames [maxFrames]]\n", argv[0]);
+	exit(1);
+    }
+    ReadTrace(argv[1]);
+    if (argc > 2)
+	minFrames = atoi(argv[2]);
+    if (argc > 3)
+	maxFrames = atoi(argv[3]);
+    if ((minFrames < 1) || (maxFrames < minFrames)) {
+	fprintf(stderr, "%s: bad range of frames\n", argv[0]);
+	exit(1);
+    }
+
+    framePage = new int[maxFrames];
+    loadTime = new int[maxFrames];
+    lastUse = new int[maxFrames];
+    nextRef = new int[maxFrames];
+    refBit = new char[maxFrames];
+    listOf = new int[maxFrames];
+    stamp = new int[maxFrames];
+    residentIn = new int[numPages + 1];
+    ghostOf = new char[numPages + 1];
+    ghostStamp = new int[numPages + 1];
+
+    printf("%d references (%d writes) to %d pages\n\n", numRefs, numWrites,
+	numPages);
+    printf("frames");
+    for (policy = 0; policy < NumPolicies; policy++)
+	printf("%9s", policyName[policy]);
+    printf("\n");
+    for (frames = minFrames; frames <= maxFrames; frames++) {
+	printf("%6d", frames);
+	for (policy = 0; policy < NumPolicies; policy++)
+	    printf("%9d", Simulate(policy, frames));
+	printf("\n");
+    }
+    return 0;
+}
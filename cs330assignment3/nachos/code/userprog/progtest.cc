@@ -26,6 +26,10 @@ BatchStartFunction (int dummy)
 // LaunchUserProcess
 // 	Run a user program.  Open the executable, load it into
 //	memory, and jump to it.
+//
+//	Returns only if the program cannot be run, either because it
+//	cannot be opened or because there is not enough swap for it; an
+//	exec leaves the old program in place then.
 //----------------------------------------------------------------------
 
 void
@@ -39,9 +43,17 @@ LaunchUserProcess(char *filename)
 	return;
     }
     space = new ProcessAddressSpace(executable, filename, currentThread->GetPID());
-    currentThread->space = space;
-
     delete executable;			// close file
+    if (!space->reserveSwap()) {
+	printf("Not enough swap space to run %s\n", filename);
+	delete space;
+	return;
+    }
+
+    if (currentThread->space != NULL) {		// exec: drop the old image
+	currentThread->space->releasePages();
+    }
+    currentThread->space = space;
 
     space->InitUserModeCPURegisters();		// set the initial register values
     space->RestoreContextOnSwitch();		// load page table register
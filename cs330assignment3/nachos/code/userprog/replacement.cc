@@ -0,0 +1,410 @@
+// replacement.cc
+//	Routines for the adaptive page replacement policies, ARC and 2Q.
+//	See replacement.h for an overview.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "replacement.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// GhostList::GhostList
+// 	Initialize an empty ghost list, that remembers at most "n" pages.
+//----------------------------------------------------------------------
+
+GhostList::GhostList(int n)
+{
+    int i;
+
+    ASSERT(n > 0);
+    capacity = n;
+    numEntries = 0;
+    pid = new int[n];
+    vpn = new int[n];
+    prev = new int[n];
+    next = new int[n];
+    chain = new int[n];
+    head = tail = -1;
+    for (i = 0; i < n; i++)		// free entries are linked by "next"
+	next[i] = i + 1;
+    next[n - 1] = -1;
+    freeList = 0;
+    for (i = 0; i < NumGhostBuckets; i++)
+	buckets[i] = -1;
+}
+
+//----------------------------------------------------------------------
+// GhostList::~GhostList
+// 	De-allocate a ghost list.
+//----------------------------------------------------------------------
+
+GhostList::~GhostList()
+{
+    delete [] pid;
+    delete [] vpn;
+    delete [] prev;
+    delete [] next;
+    delete [] chain;
+}
+
+//----------------------------------------------------------------------
+// GhostList::Append
+// 	Remember that page "v" of process "p" has just been evicted.
+//	If the list is full, the page evicted longest ago is forgotten.
+//----------------------------------------------------------------------
+
+void
+GhostList::Append(int p, int v)
+{
+    int entry, bucket = Hash(p, v);
+
+    if (numEntries == capacity)
+	RemoveOldest();
+    entry = freeList;
+    freeList = next[entry];
+
+    pid[entry] = p;
+    vpn[entry] = v;
+    chain[entry] = buckets[bucket];
+    buckets[bucket] = entry;
+    prev[entry] = tail;
+    next[entry] = -1;
+    if (tail == -1)
+	head = entry;
+    else
+	next[tail] = entry;
+    tail = entry;
+    numEntries++;
+}
+
+//----------------------------------------------------------------------
+// GhostList::Remove
+// 	Forget page "v" of process "p".
+//
+// Returns:
+//	TRUE if the page was remembered.
+//----------------------------------------------------------------------
+
+bool
+GhostList::Remove(int p, int v)
+{
+    int entry = Find(p, v);
+
+    if (entry == -1)
+	return FALSE;
+    Unlink(entry);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// GhostList::RemoveOldest
+// 	Forget the page evicted longest ago.
+//----------------------------------------------------------------------
+
+void
+GhostList::RemoveOldest()
+{
+    ASSERT(head != -1);
+    Unlink(head);
+}
+
+//----------------------------------------------------------------------
+// GhostList::Hash
+// 	The bucket a page is in.
+//----------------------------------------------------------------------
+
+int
+GhostList::Hash(int p, int v)
+{
+    return (unsigned)(p * 7919 + v) % NumGhostBuckets;
+}
+
+//----------------------------------------------------------------------
+// GhostList::Find
+// 	Return the entry remembering page "v" of process "p", -1 if none.
+//----------------------------------------------------------------------
+
+int
+GhostList::Find(int p, int v)
+{
+    int entry;
+
+    for (entry = buckets[Hash(p, v)]; entry != -1; entry = chain[entry])
+	if ((pid[entry] == p) && (vpn[entry] == v))
+	    return entry;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// GhostList::Unlink
+// 	Take an entry off its bucket and the eviction order, and put it
+//	back on the free list.
+//----------------------------------------------------------------------
+
+void
+GhostList::Unlink(int entry)
+{
+    int *link;
+
+    for (link = &buckets[Hash(pid[entry], vpn[entry])]; *link != entry;
+		link = &chain[*link])
+	ASSERT(*link != -1);
+    *link = chain[entry];
+
+    if (prev[entry] == -1)
+	head = next[entry];
+    else
+	next[prev[entry]] = next[entry];
+    if (next[entry] == -1)
+	tail = prev[entry];
+    else
+	prev[next[entry]] = prev[entry];
+
+    next[entry] = freeList;
+    freeList = entry;
+    numEntries--;
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::AdaptiveReplacement
+// 	Initialize the policy, with no page on any list.
+//----------------------------------------------------------------------
+
+AdaptiveReplacement::AdaptiveReplacement()
+{
+    int i;
+
+    for (i = 0; i < NumPhysPages; i++) {
+	listOf[i] = 0;
+	prev[i] = next[i] = -1;
+    }
+    for (i = 0; i < 3; i++) {
+	head[i] = tail[i] = -1;
+	length[i] = 0;
+    }
+    ghost[0] = NULL;
+    ghost[1] = new GhostList(NumPhysPages);
+    ghost[2] = new GhostList(NumPhysPages);
+    target = 0;
+    epoch = 0;
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::~AdaptiveReplacement
+// 	De-allocate the ghost lists.
+//----------------------------------------------------------------------
+
+AdaptiveReplacement::~AdaptiveReplacement()
+{
+    delete ghost[1];
+    delete ghost[2];
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::Inserted
+// 	Page "vpn" of process "pid" has been brought into "frame".  A page
+//	evicted recently goes straight to the second list; ARC also moves
+//	its target for T1 towards the list the page was evicted from.
+//----------------------------------------------------------------------
+
+void
+AdaptiveReplacement::Inserted(int frame, int pid, int vpn)
+{
+    ASSERT(listOf[frame] == 0);
+    pidOf[frame] = pid;
+    vpnOf[frame] = vpn;
+    epochOf[frame] = ++epoch;
+
+    if (ghost[1]->Remove(pid, vpn)) {
+	stats->ghostHits++;
+	if (pageReplacementAlgo == ARC)
+	    target = min(NumPhysPages, target +
+		max(ghost[2]->NumEntries() / (ghost[1]->NumEntries() + 1), 1));
+	Append(2, frame);
+    } else if ((pageReplacementAlgo == ARC) && ghost[2]->Remove(pid, vpn)) {
+	stats->ghostHits++;
+	target = max(0, target -
+		max(ghost[1]->NumEntries() / (ghost[2]->NumEntries() + 1), 1));
+	Append(2, frame);
+    } else {
+	stats->ghostMisses++;
+	Append(1, frame);
+    }
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::Referenced
+// 	A resident page has been used.  ARC moves it to the young end of
+//	T2; 2Q moves pages on Am to its young end, and leaves pages on
+//	A1in where they are.
+//----------------------------------------------------------------------
+
+void
+AdaptiveReplacement::Referenced(int frame)
+{
+    if ((listOf[frame] == 0) || (epochOf[frame] == epoch))
+	return;				// untracked, or still the access
+					// that brought the page in
+    if (listOf[frame] == 1) {
+	stats->recencyHits++;
+	if (pageReplacementAlgo == TWO_Q)
+	    return;
+    } else
+	stats->frequencyHits++;
+    if (tail[2] != frame) {
+	Unlink(frame);
+	Append(2, frame);
+    }
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::Removed
+// 	"frame" no longer holds a page that can be replaced: forget it,
+//	without remembering it in a ghost list.
+//----------------------------------------------------------------------
+
+void
+AdaptiveReplacement::Removed(int frame)
+{
+    if (listOf[frame] != 0)
+	Unlink(frame);
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::Victim
+// 	Choose the frame to evict, to make room for page "vpn" of process
+//	"pid", and remember its page in a ghost list.  "except" must not
+//	be chosen.
+//
+//	ARC takes the oldest page of T1 if T1 is over its target (or at
+//	it, if the incoming page was evicted from T2), otherwise the
+//	oldest page of T2.  2Q takes the oldest page of A1in if A1in holds
+//	more than a quarter of memory, otherwise the oldest page of Am.
+//	Either way, if the chosen list has nothing that can be replaced,
+//	the other one is used.
+//
+// Returns:
+//	The frame, off its list.
+//----------------------------------------------------------------------
+
+int
+AdaptiveReplacement::Victim(int except, int pid, int vpn)
+{
+    int from, frame;
+
+    if (pageReplacementAlgo == ARC)
+	from = ((length[1] > 0) && ((length[1] > target) ||
+		((length[1] == target) && ghost[2]->Contains(pid, vpn)))) ? 1 : 2;
+    else
+	from = (length[1] > max(1, NumPhysPages / 4)) ? 1 : 2;
+
+    frame = Oldest(from, except);
+    if (frame == -1) {
+	from = 3 - from;
+	frame = Oldest(from, except);
+    }
+    if (frame == -1) {
+	// only pages brought in before this policy was chosen are left
+	frame = machine->frameTable->FirstActive();
+	if (frame == except)
+	    frame = machine->frameTable->Frame(frame)->next;
+	ASSERT(frame != -1);
+	return frame;
+    }
+
+    Unlink(frame);
+    if ((from == 1) || (pageReplacementAlgo == ARC))
+	ghost[from]->Append(pidOf[frame], vpnOf[frame]);
+    TrimGhosts();
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::Oldest
+// 	Return the oldest frame on "list" that can be replaced, other than
+//	"except"; -1 if there is none.
+//----------------------------------------------------------------------
+
+int
+AdaptiveReplacement::Oldest(int list, int except)
+{
+    int frame;
+
+    for (frame = head[list]; frame != -1; frame = next[frame])
+	if ((frame != except) && machine->frameTable->IsReplaceable(frame))
+	    return frame;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::Append
+// 	Put a frame that is on no list at the young end of "list".
+//----------------------------------------------------------------------
+
+void
+AdaptiveReplacement::Append(int list, int frame)
+{
+    listOf[frame] = list;
+    next[frame] = -1;
+    prev[frame] = tail[list];
+    if (tail[list] == -1)
+	head[list] = frame;
+    else
+	next[tail[list]] = frame;
+    tail[list] = frame;
+    length[list]++;
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::Unlink
+// 	Take a frame off the list it is on.
+//----------------------------------------------------------------------
+
+void
+AdaptiveReplacement::Unlink(int frame)
+{
+    int list = listOf[frame];
+
+    if (prev[frame] == -1)
+	head[list] = next[frame];
+    else
+	next[prev[frame]] = next[frame];
+    if (next[frame] == -1)
+	tail[list] = prev[frame];
+    else
+	prev[next[frame]] = prev[frame];
+    prev[frame] = next[frame] = -1;
+    listOf[frame] = 0;
+    length[list]--;
+}
+
+//----------------------------------------------------------------------
+// AdaptiveReplacement::TrimGhosts
+// 	Keep the ghost lists to the sizes the policies allow: for ARC,
+//	T1 and B1 together hold at most one memoryful of pages, and all
+//	four lists at most two; for 2Q, A1out remembers at most half a
+//	memoryful.
+//----------------------------------------------------------------------
+
+void
+AdaptiveReplacement::TrimGhosts()
+{
+    if (pageReplacementAlgo == ARC) {
+	while ((ghost[1]->NumEntries() > 0)
+		&& (length[1] + ghost[1]->NumEntries() > NumPhysPages))
+	    ghost[1]->RemoveOldest();
+	while (length[1] + length[2] + ghost[1]->NumEntries()
+		+ ghost[2]->NumEntries() > 2 * NumPhysPages) {
+	    if (ghost[2]->NumEntries() > 0)
+		ghost[2]->RemoveOldest();
+	    else
+		ghost[1]->RemoveOldest();
+	}
+    } else {
+	while (ghost[1]->NumEntries() > max(1, NumPhysPages / 2))
+	    ghost[1]->RemoveOldest();
+    }
+}
@@ -0,0 +1,98 @@
+// replacement.h
+//	Data structures for the adaptive page replacement policies, ARC
+//	and 2Q.
+//
+//	Both keep the resident user pages on two lists: pages referenced
+//	once since they came in (ARC's T1, 2Q's A1in), and pages referenced
+//	again (T2, Am).  They also remember the (pid, vpn) of pages they
+//	evicted recently, in "ghost" lists, so that a page faulted back in
+//	soon after its eviction can be recognized:
+//
+//	  ARC	evicts from T1 or T2 so as to keep T1 near a target size,
+//		which grows on faults on pages recently evicted from T1
+//		(ghost list B1) and shrinks on faults on pages recently
+//		evicted from T2 (ghost list B2).
+//	  2Q	keeps A1in, a FIFO, to a quarter of memory; pages evicted
+//		from it are remembered in A1out, and only a fault on a page
+//		in A1out puts it on Am, an LRU list.
+//
+//	So a scan passes through T1 or A1in without flushing the pages a
+//	hot loop keeps reusing.
+//
+//	A reference counts as a second one only if some other page has
+//	been brought in since the page was: otherwise every page would be
+//	"referenced again" by the very access that faulted it in.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REPLACEMENT_H
+#define REPLACEMENT_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define NumGhostBuckets		31	// hash buckets of a ghost list
+
+// A bounded list of the (pid, vpn) of evicted pages, oldest first.
+
+class GhostList {
+  public:
+    GhostList(int capacity);		// empty to start with
+    ~GhostList();
+
+    void Append(int p, int v);	// remember a page; forget the
+					// oldest one if full
+    bool Remove(int p, int v);	// forget a page; FALSE if it was
+					// not remembered
+    bool Contains(int p, int v) { return (Find(p, v) != -1); }
+    void RemoveOldest();
+    int NumEntries() { return numEntries; }
+
+  private:
+    int capacity, numEntries;
+    int *pid, *vpn;			// the entries
+    int *prev, *next;			// order of eviction, -1 at the ends
+    int *chain;				// next entry in the same bucket
+    int head, tail, freeList;
+    int buckets[NumGhostBuckets];
+
+    int Hash(int p, int v);
+    int Find(int p, int v);
+    void Unlink(int entry);
+};
+
+// The resident lists of the two policies.  pageReplacementAlgo says
+// which one is in use.
+
+class AdaptiveReplacement {
+  public:
+    AdaptiveReplacement();
+    ~AdaptiveReplacement();
+
+    void Inserted(int frame, int pid, int vpn);	// page faulted in
+    void Referenced(int frame);			// resident page used
+    void Removed(int frame);			// frame freed or pinned
+    int Victim(int except, int pid, int vpn);	// frame to evict, to
+						// make room for (pid, vpn)
+
+  private:
+    int listOf[NumPhysPages];		// 0 if none, 1 (T1, A1in), 2 (T2, Am)
+    int prev[NumPhysPages], next[NumPhysPages];	// oldest first
+    int pidOf[NumPhysPages], vpnOf[NumPhysPages];
+    int epochOf[NumPhysPages];		// "epoch" when the page came in
+    int head[3], tail[3], length[3];
+
+    GhostList *ghost[3];		// B1, B2 for ARC; A1out, unused
+					// for 2Q
+    int target;				// ARC: target length of T1
+    int epoch;				// pages brought in so far
+
+    int Oldest(int list, int except);	// oldest replaceable frame
+    void Append(int list, int frame);
+    void Unlink(int frame);
+    void TrimGhosts();
+};
+
+#endif // REPLACEMENT_H
@@ -0,0 +1,162 @@
+// swap.cc
+//	Routines to manage the swap area.  See swap.h for an overview.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "swap.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// SwapManager::SwapManager
+// 	Open the swap disk, with every slot free.  Whatever the disk held
+//	from an earlier run is garbage.
+//
+//	"name" -- the UNIX file simulating the swap disk
+//----------------------------------------------------------------------
+
+SwapManager::SwapManager(char *name)
+{
+    int i;
+
+    ASSERT(PageSize == SectorSize);
+    disk = new SynchDisk(name);
+    slotMap = new BitMap(NumSwapSlots);
+    slotRefs = new int[NumSwapSlots];
+    for (i = 0; i < NumSwapSlots; i++)
+	slotRefs[i] = 0;
+    reserved = 0;
+    pagingLock = new Lock("paging lock");
+    pageInDone = new Condition("page-in done");
+}
+
+//----------------------------------------------------------------------
+// SwapManager::~SwapManager
+// 	Close the swap disk.
+//----------------------------------------------------------------------
+
+SwapManager::~SwapManager()
+{
+    delete pageInDone;
+    delete pagingLock;
+    delete [] slotRefs;
+    delete slotMap;
+    delete disk;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Reserve
+// 	Promise a slot to each of "pages" pages of a new address space,
+//	if there are that many not promised yet.  No slot is taken until
+//	a page is actually written out.
+//
+// Returns:
+//	TRUE if the pages fit, FALSE (reserving nothing) otherwise.
+//----------------------------------------------------------------------
+
+bool
+SwapManager::Reserve(int pages)
+{
+    if (reserved + pages > NumSwapSlots) {
+	DEBUG('w', "Cannot reserve %d swap slots, %d of %d taken\n",
+	      pages, reserved, NumSwapSlots);
+	return FALSE;
+    }
+    reserved += pages;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::Unreserve
+// 	An address space that reserved "pages" slots is gone.
+//----------------------------------------------------------------------
+
+void
+SwapManager::Unreserve(int pages)
+{
+    ASSERT(pages <= reserved);
+    reserved -= pages;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::AllocateSlot
+// 	Find a free slot for a page being evicted.
+//
+//	There always is one: a slot in use belongs to at least one page
+//	of a live address space, and those reserved a slot per page.  The
+//	slot a page is moving off is shared when a new one is taken, so
+//	even then there are no more slots than pages.
+//
+// Returns:
+//	The slot, with one reference.
+//----------------------------------------------------------------------
+
+int
+SwapManager::AllocateSlot()
+{
+    int slot = slotMap->Find();
+
+    ASSERT(slot != -1);			// would mean a page without a reservation
+    slotRefs[slot] = 1;
+    DEBUG('w', "Allocated swap slot %d\n", slot);
+    return slot;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::ShareSlot
+// 	Another page table refers to "slot" (after a fork).
+//----------------------------------------------------------------------
+
+void
+SwapManager::ShareSlot(int slot)
+{
+    ASSERT(slotMap->Test(slot) && slotRefs[slot] > 0);
+    slotRefs[slot]++;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::FreeSlot
+// 	A page table no longer refers to "slot".  The last one to let go
+//	frees it.
+//----------------------------------------------------------------------
+
+void
+SwapManager::FreeSlot(int slot)
+{
+    ASSERT(slotMap->Test(slot) && slotRefs[slot] > 0);
+    if (--slotRefs[slot] == 0) {
+	slotMap->Clear(slot);
+	DEBUG('w', "Freed swap slot %d\n", slot);
+    }
+}
+
+//----------------------------------------------------------------------
+// SwapManager::ReadPage
+// 	Read a page back from its slot.  Returns only after the disk is
+//	done; other threads run meanwhile.  The caller need not hold the
+//	paging lock.
+//----------------------------------------------------------------------
+
+void
+SwapManager::ReadPage(int slot, char *data)
+{
+    ASSERT(slotMap->Test(slot));
+    disk->ReadSector(slot, data);
+    stats->swapIns++;
+}
+
+//----------------------------------------------------------------------
+// SwapManager::WritePage
+// 	Write an evicted page to its slot.  Returns only after the disk
+//	is done; other threads run meanwhile.
+//----------------------------------------------------------------------
+
+void
+SwapManager::WritePage(int slot, char *data)
+{
+    ASSERT(slotMap->Test(slot));
+    disk->WriteSector(slot, data);
+    stats->swapOuts++;
+}
@@ -0,0 +1,71 @@
+// swap.h
+//	Data structures to manage the swap area, where pages evicted
+//	from main memory are kept until they are needed again.
+//
+//	The swap area is a simulated disk of its own (the UNIX file
+//	"SWAP"), so that paging pays the seek, rotational and transfer
+//	delays of the disk.  A page is exactly one sector, and each
+//	sector of the disk is a swap slot.
+//
+//	A slot can be shared by the address spaces of a parent and the
+//	children it forked, so each slot has a count of the page tables
+//	referring to it; it is free again when the count drops to zero.
+//
+//	Swap is reserved when an address space is made, one slot for each
+//	of its pages that can be evicted, and Exec or Fork fail if there
+//	are not enough slots left.  Every page written out then has a
+//	slot waiting for it, so eviction never runs out of swap.
+//
+//	All page replacement happens with the paging lock held, so that
+//	two threads never pick the same victim frame.  Page-outs keep the
+//	lock while they wait for the disk; page-ins do not, so that other
+//	threads can fault meanwhile.  Their frame is kept out of reach of
+//	replacement instead (FrameTable::BeginIO), and a thread that finds
+//	every frame busy waits for a page-in to finish.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "copyright.h"
+#include "bitmap.h"
+#include "synch.h"
+#include "synchdisk.h"
+
+#define NumSwapSlots	NumSectors
+
+class SwapManager {
+  public:
+    SwapManager(char *name);		// open (or create) the swap disk
+    ~SwapManager();
+
+    bool Reserve(int pages);		// back "pages" more pages with swap;
+					// FALSE if there is not enough left
+    void Unreserve(int pages);		// those pages are gone
+
+    int AllocateSlot();			// a free slot, referenced once
+    void ShareSlot(int slot);		// one more page table refers to it
+    void FreeSlot(int slot);		// one less; free it at zero
+    int SlotRefs(int slot) { return slotRefs[slot]; }
+
+    void ReadPage(int slot, char *data);	// page in, from "slot"
+    void WritePage(int slot, char *data);	// page out, to "slot"
+
+    void AcquirePaging() { pagingLock->Acquire(); }
+    void ReleasePaging() { pagingLock->Release(); }
+    void WaitForPageIn() { pageInDone->Wait(pagingLock); }
+    void PageInDone() { pageInDone->Broadcast(pagingLock); }
+
+  private:
+    SynchDisk *disk;			// the swap area
+    BitMap *slotMap;			// which slots are in use
+    int *slotRefs;			// page tables referring to each slot
+    int reserved;			// slots promised to address spaces
+    Lock *pagingLock;			// serializes page replacement
+    Condition *pageInDone;		// a busy frame became replaceable
+};
+
+#endif // SWAP_H
@@ -49,6 +49,8 @@
 #define SysCall_CondOp		25
 #define SysCall_CondRemove	26
 #define SysCall_ShmAllocate	27
+#define SysCall_RingSetup	28
+#define SysCall_RingEnter	29
 #define SysCall_NumInstr        50
 
 #ifndef IN_ASM
@@ -181,6 +183,54 @@ int syscall_wrapper_CondRemove (int condid);
 unsigned syscall_wrapper_ShmAllocate (unsigned size);
 
 int syscall_wrapper_GetNumInstr (void);
+
+/* A submission ring and a completion ring, in shared memory, so that a
+ * program can make many system calls with one trap.  RingSetup makes
+ * them; the program writes requests at sqTail, and RingEnter runs the
+ * queued requests in order, posting a completion for each at cqTail.
+ *
+ * The four counters only ever grow; entry i of a ring is at
+ * i % entries.  The kernel advances sqHead and cqTail, the program
+ * sqTail and cqHead.  Only the system calls that just take one
+ * argument and return, like the Print calls, Sleep or GetTime, can be
+ * queued; the others complete with -1.
+ */
+#define RING_MAX_ENTRIES	32
+
+typedef struct {
+  int entries;			/* in each ring */
+  int sqHead, sqTail;		/* submissions */
+  int cqHead, cqTail;		/* completions */
+} RingHeader;			/* followed by entries RingRequests, then
+				 * entries RingCompletions */
+
+typedef struct {
+  int type;			/* SysCall_PrintInt, ... */
+  int arg;			/* its argument */
+  int userData;			/* handed back in the completion */
+} RingRequest;
+
+typedef struct {
+  int userData;
+  int result;			/* what the system call returned, 0 if
+				 * nothing, -1 if it cannot be queued */
+} RingCompletion;
+
+#define RingSubmission(ring, i) \
+	(&((RingRequest *) ((ring) + 1))[(i) % (ring)->entries])
+#define RingCompletionEntry(ring, i) \
+	(&((RingCompletion *) ((RingRequest *) ((ring) + 1) + (ring)->entries)) \
+	  [(i) % (ring)->entries])
+
+/* Make the rings, with "entries" entries each, and return where they
+ * are; 0 if "entries" is out of range, or there are rings already.
+ */
+RingHeader *syscall_wrapper_RingSetup (int entries);
+
+/* Run up to "max" queued requests (all of them, if "max" is 0), or
+ * fewer if the completion ring fills up; return how many were run.
+ */
+int syscall_wrapper_RingEnter (int max);
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
@@ -0,0 +1,82 @@
+// trace.cc
+//	Routines to record page reference traces.  See trace.h for an
+//	overview.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "trace.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// ReferenceTrace::ReferenceTrace
+// 	Create (or truncate) the trace file, and write its magic number.
+//
+//	"fileName" -- the UNIX file to record the references in
+//----------------------------------------------------------------------
+
+ReferenceTrace::ReferenceTrace(char *fileName)
+{
+    unsigned int magic = TRACE_MAGIC;
+
+    file = OpenForWrite(fileName);
+    WriteFile(file, (char *) &magic, sizeof(magic));
+    numBuffered = 0;
+    haveLast = FALSE;
+    numRecords = 0;
+}
+
+//----------------------------------------------------------------------
+// ReferenceTrace::~ReferenceTrace
+// 	Write out the references still held, and close the trace file.
+//----------------------------------------------------------------------
+
+ReferenceTrace::~ReferenceTrace()
+{
+    if (haveLast)
+	buffer[numBuffered++] = last;
+    Flush();
+    Close(file);
+    DEBUG('v', "Recorded %d page references\n", numRecords);
+}
+
+//----------------------------------------------------------------------
+// ReferenceTrace::Record
+// 	Note a reference by process "pid" to its virtual page "vpn".
+//	A reference to the same page as the one before is folded into it.
+//----------------------------------------------------------------------
+
+void
+ReferenceTrace::Record(int pid, int vpn, bool writing)
+{
+    unsigned int record = TraceRecord(pid, vpn, writing);
+
+    ASSERT((vpn >= 0) && (vpn <= 0xffff) && (pid >= 0) && (pid < (1 << 15)));
+    if (haveLast && (TracePage(last) == TracePage(record))) {
+	last |= record;
+	return;
+    }
+    if (haveLast) {
+	buffer[numBuffered++] = last;
+	if (numBuffered == TraceBufferSize)
+	    Flush();
+    }
+    last = record;
+    haveLast = TRUE;
+}
+
+//----------------------------------------------------------------------
+// ReferenceTrace::Flush
+// 	Write the buffered references to the trace file.
+//----------------------------------------------------------------------
+
+void
+ReferenceTrace::Flush()
+{
+    if (numBuffered > 0)
+	WriteFile(file, (char *) buffer, numBuffered * sizeof(unsigned int));
+    numRecords += numBuffered;
+    numBuffered = 0;
+}
@@ -0,0 +1,53 @@
+// trace.h
+//	Data structures to record the page references of user programs,
+//	so that page replacement policies can be compared offline (see
+//	pagesim.cc) against Belady's optimal policy.
+//
+//	Nachos started with "-T file" writes every reference to a user
+//	page to the UNIX file "file": a magic number, then one 32-bit word
+//	per reference, in host byte order, holding the pid, the virtual
+//	page and whether it was a write.  Repeated references to the same
+//	page are recorded once (as a write if any of them was), since they
+//	cannot change what any replacement policy does.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+
+#define TRACE_MAGIC	0x4e545243	// first word of a trace file
+
+// Encoding of a reference: bit 0 is set for a write, bits 1-16 hold
+// the virtual page, and bits 17-31 the pid.
+#define TraceRecord(pid, vpn, writing) \
+	(((unsigned)(pid) << 17) | ((unsigned)(vpn) << 1) | ((writing) ? 1 : 0))
+#define TracePid(r)	((int)((r) >> 17))
+#define TraceVpn(r)	((int)(((r) >> 1) & 0xffff))
+#define TraceIsWrite(r)	((r) & 1)
+#define TracePage(r)	((r) >> 1)	// pid and vpn together
+
+#define TraceBufferSize	1024		// references written at a time
+
+class ReferenceTrace {
+  public:
+    ReferenceTrace(char *fileName);	// create the trace file
+    ~ReferenceTrace();			// write what is left, and close it
+
+    void Record(int pid, int vpn, bool writing);  // one more reference
+
+  private:
+    int file;				// UNIX file descriptor
+    unsigned int buffer[TraceBufferSize];  // references not yet written
+    int numBuffered;
+    unsigned int last;			// the latest reference, not yet
+    bool haveLast;			// buffered in case it repeats
+    int numRecords;			// references written, for DEBUG
+
+    void Flush();			// write the buffer out
+};
+
+#endif // TRACE_H